@@ -27,15 +27,180 @@ SOFTWARE.
 // #define VERBOSE
 #include "Tools.h"
 
-#include <map>
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
 #include <unordered_map>
+#include <unordered_set>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(LASKENTA_THREADS)
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#endif
+
+#if defined(LASKENTA_JIT)
+#if !defined(__x86_64__) && !defined(_M_X64)
+#error "LASKENTA_JIT emits x86-64 machine code"
+#elif defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
 
 //**********************************************************************************************************************
 
-auto const STACK_LIMIT = 10000;
-
 using Attr = Expression::Attribute;
 using Expr = Expression::data;
+using Substitution = std::unordered_map<size_t, Expr const*>;  // Bound expression by 'Variable::id()'
+
+#if defined(LASKENTA_THREADS)
+using Mutex = std::recursive_mutex;  // Constructing a node may enter the same table again, for its operands
+template <typename T> using Counter = std::atomic<T>;
+#else
+struct Mutex { void lock() { } void unlock() { } };  // Nothing to lock when the expressions are constructed by one thread
+template <typename T> using Counter = T;
+#endif
+
+using Guard = std::lock_guard<Mutex>;
+
+static inline int lowestBit(uint64_t m)
+{
+#if defined(_MSC_VER)
+    unsigned long n;
+    _BitScanForward64(&n, m);
+    return int(n);
+#else
+    return __builtin_ctzll(m);
+#endif
+}
+
+/***********************************************************************************************************************
+*** NodePool
+***********************************************************************************************************************/
+
+struct NodePool final  // Slab allocator for the nodes of one size class
+{
+    static size_t const GRAIN = 16;  // Size classes are multiples of this, which is also the alignment of the nodes
+    static size_t const LARGEST = 128;  // Larger nodes are allocated from the heap
+    static size_t const SLAB = 65536;
+
+    explicit NodePool(size_t n) : size(n), next(nullptr), end(nullptr), free(nullptr), live(0) { }
+
+    void* allocate()
+    {
+        Guard guard(mutex);
+        ++live;
+
+        if (free)  // Reuse the most recently released node
+        {
+            void* p = free;
+            free = *static_cast<void**>(p);
+            return p;
+        }
+
+        if (next == end) refill();
+
+        void* p = next;
+        next += size;
+        return p;
+    }
+
+    void release(void* p)
+    {
+        Guard guard(mutex);
+        *static_cast<void**>(p) = free;
+        free = p;
+
+        if (!--live) reset();
+    }
+
+    static NodePool& instance(size_t);
+
+    template <typename T> struct Allocator  // For containers of the nodes, like the operand lists of n-ary nodes
+    {
+        using value_type = T;
+
+        Allocator() { }
+        template <typename U> Allocator(Allocator<U> const&) { }
+
+        T* allocate(size_t n)
+        {
+            auto const size = n * sizeof(T);
+            return static_cast<T*>(size <= LARGEST ? instance(size).allocate() : ::operator new(size));
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            auto const size = n * sizeof(T);
+            if (size <= LARGEST) instance(size).release(p); else ::operator delete(p);
+        }
+
+        template <typename U> bool operator==(Allocator<U> const&) const { return true; }
+        template <typename U> bool operator!=(Allocator<U> const&) const { return false; }
+    };
+
+private:
+    void refill();
+    void reset();
+
+    size_t const size;
+    char* next;  // Nodes created in sequence are allocated next to each other from the current slab
+    char* end;
+    void* free;  // Released nodes, linked through their first word
+    size_t live;
+    std::vector<char*> slabs;
+    Mutex mutex;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void NodePool::refill()
+{
+    slabs.push_back(static_cast<char*>(::operator new(SLAB)));
+    next = slabs.back();
+    end = next + SLAB / size * size;
+}
+
+void NodePool::reset()
+{
+    // When the last node is released, all the memory but the first slab is released in bulk
+
+    while (slabs.size() > 1)
+    {
+        ::operator delete(slabs.back());
+        slabs.pop_back();
+    }
+
+    free = nullptr;
+    next = slabs.front();
+    end = next + SLAB / size * size;
+}
+
+NodePool& NodePool::instance(size_t n)
+{
+    // Never destroyed, so that nodes can be released by the destructors of statics.  All the pools are created at once,
+    // when first needed, so that no thread sees one half created.
+
+    static NodePool* const* const pool = []
+    {
+        auto const p = new NodePool*[LARGEST / GRAIN + 1];
+        for (size_t i = 0; i <= LARGEST / GRAIN; ++i) p[i] = new NodePool(i ? i * GRAIN : GRAIN);
+        return p;
+    }();
+
+    return *pool[(n + GRAIN - 1) / GRAIN];
+}
 
 /***********************************************************************************************************************
 *** Expression::data
@@ -92,16 +257,47 @@ struct Expression::data : public Shared
     virtual Expr const* commutative_mul(Expr const*) const;
     virtual Expr const* pow(Expr const*) const;
 
-    // Evaluation and derivation
+    using Terms = std::vector<Expr const*, NodePool::Allocator<Expr const*>>;  // Operands of the n-ary nodes
+
+    struct Operands  // View of the operands of an n-ary node, either of 'Terms' or of the block held by the node
+    {
+        Operands(Terms const& r) : first(r.data()), count(r.size()) { }
+        Operands(Expr const* const* p, size_t n) : first(p), count(n) { }
+
+        Expr const* const* begin() const { return first; }
+        Expr const* const* end() const { return first + count; }
+        Expr const* operator[](size_t i) const { return first[i]; }
+        size_t size() const { return count; }
+
+    private:
+        Expr const* const* first;
+        size_t count;
+    };
+
+    static Expr const* sum(Terms);
+    static Expr const* product(Terms);
 
-    virtual Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const&) const = 0;
+    // Evaluation and derivation
 
-    Expr const* derive(Variable const& r) const { return Clone(cachedNode ? cachedNode : cachedNode = derivative(r)); }
-    double evaluate() const { if (cleanLevel != dirtyLevel) { valueCache = value(); cleanLevel = dirtyLevel; } return valueCache; }
+    Expr const* bind(Substitution const&) const;
+    Expr const* derive(Variable const&) const;
+    double evaluate() const;
+    virtual Expr const* partial(int) const { return constant(0); }  // Derivative with respect to 'operand(n)'
 
     // Analysis tools
 
-    virtual bool guaranteed(Attr) const = 0;
+    bool guaranteed(Attr) const;  // Inferred by 'attribute()' once, then remembered
+    virtual bool attribute(Attr) const = 0;
+
+    struct Interval  // Bounds of the values wherever the node is defined
+    {
+        double lo;
+        double hi;
+    };
+
+    Interval range() const;  // Propagated by 'interval()' from the declared ranges of the variables, then remembered
+    virtual Interval interval() const { return { -HUGE_VAL, HUGE_VAL }; }
+    bool implied(Attr) const;  // Whether 'range()' alone guarantees an attribute of the value
 
     enum class NodeType
     {
@@ -115,41 +311,85 @@ struct Expression::data : public Shared
     virtual bool easyInvert() const { return false; }
     virtual bool easyNegate() const { return false; }
 
+    // Structure
+
+    virtual NodeType type() const = 0;
+    virtual Expr const* operand(int) const { return nullptr; }
+
     // Cache management
 
-    mutable std::map<NodeType, Expr const*> functionNode;
-    mutable std::map<Expr const*, Expr const*> addNode;
-    mutable std::map<Expr const*, Expr const*> mulNode;
-    mutable std::map<Expr const*, Expr const*> powNode;
+    static Mutex& stripe(NodeType, Expr const*, Expr const* = nullptr);  // Of the table that has the key
+    static Mutex& stripe(NodeType, Operands);
+    static Expr const* lookup(NodeType, Expr const*, Expr const* = nullptr);
+    static Expr const* lookup(NodeType, Operands);
+    static void enter(Expr const*, NodeType, Expr const*, Expr const* = nullptr);
+    static void enter(Expr const*, NodeType, Operands);
+    static void leave(Expr const*, NodeType, Expr const*, Expr const* = nullptr);
+    static void leave(Expr const*, NodeType, Operands);
 
     // Lazy evaluation, etc.
 
     int32_t const depth;
+    uint32_t const serial;  // Order of creation, which is the order of the terms of n-ary nodes
+    uint64_t const dependencies;  // The bits of the variables in the subgraph, see 'dependency()'
     static size_t dirtyLevel;
-    mutable Expr const* cachedNode;
-    virtual void purge() const { if (cachedNode) { Erase(cachedNode); cachedNode = nullptr; } }
+    static size_t touchLevel[64];  // Number of assignments to the variables of each bit
+    static uint64_t dependency(Variable const&);
+    static void touch(uint64_t);
+#if defined(LASKENTA_THREADS)
+    static thread_local std::unordered_map<Expr const*, Expr const*> cachedNodes;  // Of each thread, see 'cached()'
+#else
+    mutable Expr const* cachedNode = nullptr;
+#endif
+    Expr const*& cached() const;  // Result of 'bind()' or 'derive()' while one of them is being called
+    void purge() const;
+
+    struct Memo;
+    mutable Memo* memo;  // Derivatives and attributes remembered across the calls, see 'Memo'
+    Expr const* recall(size_t) const;  // Cloned
+    void remember(size_t, Expr const*) const;
+    void forget() const;
 
     operator Expr const* () const;
 
-    virtual void print(std::ostream& r) const = 0;
+    struct Token final  // Pending output of 'print()': either a literal or a subexpression
+    {
+        Token(char const* s) : text(s), node(nullptr) { }
+        Token(Expr const* p) : text(nullptr), node(p) { }
+
+        char const* text;
+        Expr const* node;
+    };
+
+    void print(std::ostream&) const;
+    virtual void print(std::ostream&, std::vector<Token>&) const = 0;
 
 protected:
-    explicit data(int32_t n) : depth(n), cachedNode(nullptr), cleanLevel(0), valueCache(0) { }
-    virtual ~data() { }
+    data(int32_t n, uint64_t m) : depth(n), serial(serials++), dependencies(m), memo(nullptr), cleanLevel(0), checkLevel(0), valueCache(0) { }
+    virtual ~data();
+    void operator delete(void* p, size_t n) { if (n <= NodePool::LARGEST) NodePool::instance(n).release(p); else ::operator delete(p); }
 
     static std::unordered_map<double, Expr const*> constantNode;
     static std::unordered_map<size_t, Expr const*> variableNode;
 
 private:
+    static Counter<uint32_t> serials;
+
     mutable size_t cleanLevel;
+    mutable size_t checkLevel;
     mutable double valueCache;
 
+    size_t touched() const;
+    bool clean() const;
+    void refresh() const;
+
+    virtual Expr const* binding(Substitution const&) const = 0;
     virtual Expr const* derivative(Variable const&) const = 0;
     virtual double value() const = 0;
 
     Expr const* function(NodeType n) const;
 
-    void* operator new(size_t n) { return ::operator new(n); }
+    void* operator new(size_t n) { return n <= NodePool::LARGEST ? NodePool::instance(n).allocate() : ::operator new(n); }
     void* operator new[](size_t) = delete;
 };
 
@@ -160,1633 +400,2053 @@ inline Expression::data::operator Expr const* () const
     return this;
 }
 
-//----------------------------------------------------------------------------------------------------------------------
+template <typename Skip, typename Visit> static void postorder(Expr const* root, Skip skip, Visit visit)
+{
+    // Visit the DAG operands first using an explicit stack so that the depth of the graph is not limited by the depth
+    // of the call stack.  The subgraphs for which 'skip()' holds are not entered; 'visit()' must make 'skip()' hold so
+    // that every shared node gets visited only once.
 
-size_t Expression::data::dirtyLevel = 1LL;
-std::unordered_map<double, Expr const*> Expression::data::constantNode;
-std::unordered_map<size_t, Expr const*> Expression::data::variableNode;
+    std::vector<std::pair<Expr const*, int>> stack;
 
-/***********************************************************************************************************************
-*** FunctionNode
-***********************************************************************************************************************/
+    if (!skip(root)) stack.emplace_back(root, 0);
 
-struct FunctionNode : public Expr
-{
-    FunctionNode(Expr const* p, NodeType n) : Expr(p->depth + 1), f_x(p), fn(n)
+    while (!stack.empty())
     {
-        assert(f_x->functionNode.find(fn) == f_x->functionNode.end());
-        f_x->functionNode[fn] = this;
+        auto& top = stack.back();
+
+        if (auto p = top.first->operand(top.second++))
+        {
+            if (!skip(p)) stack.emplace_back(p, 0);
+        }
+        else
+        {
+            auto done = top.first;
+            stack.pop_back();
+            visit(done);
+        }
     }
+}
 
-    bool is(NodeType t) const override final { return t == fn; }
-    bool is(NodeType t, Expr const* p) const override final { return t == fn && p == f_x; }
+//----------------------------------------------------------------------------------------------------------------------
 
-    void purge() const override final { if (cachedNode) { Expr::purge(); f_x->purge(); } }
+inline size_t Expression::data::touched() const
+{
+    if (!~dependencies) return dirtyLevel;  // With every bit set any assignment is relevant
 
-protected:
-    virtual ~FunctionNode()
-    {
-        assert(f_x->functionNode.find(fn) != f_x->functionNode.end() && f_x->functionNode[fn] == this);
-        f_x->functionNode.erase(fn);
-        Erase(f_x);
-    }
+    size_t n = 0;
+    for (auto m = dependencies; m; m &= m - 1) n += touchLevel[lowestBit(m)];
+    return n;
+}
 
-    Expr const* const f_x;
+inline bool Expression::data::clean() const
+{
+    // Any assignment makes 'dirtyLevel' differ from 'cleanLevel', but the value needs to be recomputed only if one of
+    // the variables in the subgraph was assigned to.  The sum of their assignment counts tells exactly that.
 
-private:
-    NodeType const fn;
-};
+    if (cleanLevel == dirtyLevel) return true;
+    if (!cleanLevel || touched() != checkLevel) return false;
 
-/***********************************************************************************************************************
-*** OperatorNode
-***********************************************************************************************************************/
+    cleanLevel = dirtyLevel;
+    return true;
+}
 
-struct OperatorNode : public Expr
+inline double Expression::data::evaluate() const
 {
-    OperatorNode(Expr const* p, Expr const* q) : Expr(std::max(p->depth, q->depth) + 1), f_x(p), g_x(q) { }
+#if defined(LASKENTA_THREADS)
+    if (!dependencies) return value();  // The constants are shared by the threads, so their values are not cached
+#endif
 
-    bool is(NodeType, Expr const*) const override final { return false; }
+    if (cleanLevel != dirtyLevel) refresh();
+    return valueCache;
+}
 
-    void purge() const override final { if (cachedNode) { Expr::purge(); f_x->purge(); g_x->purge(); } }
+inline Expr const*& Expression::data::cached() const
+{
+    // Each thread binds and derives in a table of its own, so that they need not wait for each other when the graphs
+    // share nodes.  One thread makes one call at a time, so all of the entries of its table belong to the same call.
 
-protected:
-    virtual ~OperatorNode()
-    {
-        Erase(f_x);
-        Erase(g_x);
-    }
+#if defined(LASKENTA_THREADS)
+    return cachedNodes[this];
+#else
+    return cachedNode;
+#endif
+}
 
-    Expr const* const f_x;
-    Expr const* const g_x;
-};
+inline Expr const* Expression::data::bind(Substitution const& r) const
+{
+    if (!cached()) postorder(this, [](Expr const* p) { return p->cached() != nullptr; }, [&r](Expr const* p) { p->cached() = p->binding(r); });
+    return Clone(cached());
+}
 
-/***********************************************************************************************************************
-*** Nan
-***********************************************************************************************************************/
+//----------------------------------------------------------------------------------------------------------------------
 
-struct Nan final : public Expr
+void Expression::data::refresh() const
 {
-    static Nan const instance;
+    // The stale values are brought up to date operands first, so every 'value()' finds its operands already evaluated.
+    // The terms of a product are brought up to date in order until one of them is 0, after which 'Mul::value()' asks
+    // none of the rest, so a branch pruned by a factor of 0 is not evaluated at all.
 
-    Expr const* abs() const override final { return Clone(this); }
-    Expr const* sgn() const override final { return Clone(this); }
-    Expr const* sqrt() const override final { return Clone(this); }
-    Expr const* cbrt() const override final { return Clone(this); }
-    Expr const* exp() const override final { return Clone(this); }
-    Expr const* expm1() const override final { return Clone(this); }
-    Expr const* log() const override final { return Clone(this); }
-    Expr const* log1p() const override final { return Clone(this); }
-    Expr const* sin() const override final { return Clone(this); }
-    Expr const* cos() const override final { return Clone(this); }
-    Expr const* tan() const override final { return Clone(this); }
-    Expr const* sec() const override final { return Clone(this); }
-    Expr const* asin() const override final { return Clone(this); }
-    Expr const* acos() const override final { return Clone(this); }
-    Expr const* atan() const override final { return Clone(this); }
-    Expr const* sinh() const override final { return Clone(this); }
-    Expr const* cosh() const override final { return Clone(this); }
-    Expr const* tanh() const override final { return Clone(this); }
-    Expr const* sech() const override final { return Clone(this); }
-    Expr const* asinh() const override final { return Clone(this); }
-    Expr const* acosh() const override final { return Clone(this); }
-    Expr const* atanh() const override final { return Clone(this); }
-    Expr const* erf() const override final { return Clone(this); }
-    Expr const* erfc() const override final { return Clone(this); }
+    std::vector<std::pair<Expr const*, int>> stack;
 
-    Expr const* invert() const override final { return Clone(this); }
-    Expr const* negate() const override final { return Clone(this); }
-    Expr const* softpp() const override final { return Clone(this); }
-    Expr const* spence() const override final { return Clone(this); }
-    Expr const* square() const override final { return Clone(this); }
-    Expr const* xconic() const override final { return Clone(this); }
-    Expr const* yconic() const override final { return Clone(this); }
-    Expr const* zconic() const override final { return Clone(this); }
+    if (!clean()) stack.emplace_back(this, 0);
 
-    Expr const* add(Expr const*) const override final { return Clone(this); }
-    Expr const* commutative_add(Expr const*) const override final { return Clone(this); }
-    Expr const* mul(Expr const*) const override final { return Clone(this); }
-    Expr const* commutative_mul(Expr const*) const override final { return Clone(this); }
-    Expr const* pow(Expr const*) const override final { return Clone(this); }
+    while (!stack.empty())
+    {
+        auto& top = stack.back();
+        auto const p = top.first;
+        auto q = p->operand(top.second);
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const&) const override final { return Clone(this); }
+        if (q && top.second && p->is(NodeType::MUL) && p->operand(top.second - 1)->evaluate() == 0) q = nullptr;
 
-    bool guaranteed(Attr) const override final { return false; }
+        if (q)
+        {
+            ++top.second;
+            if (!q->clean()) stack.emplace_back(q, 0);
+        }
+        else
+        {
+            stack.pop_back();
+            p->valueCache = p->value();
+            p->checkLevel = p->touched();
+            p->cleanLevel = dirtyLevel;
+        }
+    }
+}
 
-    bool is(NodeType) const override final { return false; }
-    bool is(NodeType, Expr const*) const override final { return false; }
+void Expression::data::purge() const
+{
+#if defined(LASKENTA_THREADS)
+    for (auto& r : cachedNodes) Erase(r.second);
+    cachedNodes.clear();
+#else
+    postorder(this, [](Expr const* p) { return !p->cachedNode; }, [](Expr const* p)
+    {
+        Erase(p->cachedNode);
+        p->cachedNode = nullptr;
+    });
+#endif
+}
 
-    Expr const* derivative(Variable const&) const override final { return Clone(this); }
-    double value() const override final { return nan(__FUNCTION__); }
+void Expression::data::print(std::ostream& out) const
+{
+    std::vector<Token> stack{ this };
 
-    void print(std::ostream& out) const override final { out << "nan"; }
+    while (!stack.empty())
+    {
+        auto token = stack.back();
+        stack.pop_back();
 
-private:
-    Nan() : Expr(0) { }
-};
+        if (token.node)
+        {
+            auto const n = stack.size();
+            token.node->print(out, stack);
+            std::reverse(stack.begin() + n, stack.end());  // Tokens are listed in the order of output
+        }
+        else
+        {
+            out << token.text;
+        }
+    }
+}
 
 //----------------------------------------------------------------------------------------------------------------------
 
-Nan const Nan::instance;
+size_t Expression::data::dirtyLevel = 1LL;
+size_t Expression::data::touchLevel[64];
+Counter<uint32_t> Expression::data::serials;
+#if defined(LASKENTA_THREADS)
+thread_local std::unordered_map<Expr const*, Expr const*> Expression::data::cachedNodes;
+#endif
+std::unordered_map<double, Expr const*> Expression::data::constantNode;
+std::unordered_map<size_t, Expr const*> Expression::data::variableNode;
+
+static Mutex& leaves()  // Of 'constantNode' and 'variableNode', never destroyed so that the statics can release nodes
+{
+    static auto& mutex = *new Mutex;
+    return mutex;
+}
 
 /***********************************************************************************************************************
-*** ConstantNode
+*** NodeTable
 ***********************************************************************************************************************/
 
-struct ConstantNode final : public Expr, private ObjectGuard<ConstantNode>
+struct NodeTable final  // Open addressing hash table of all the function and operator nodes by their type and operands
 {
-    explicit ConstantNode(double d) : Expr(0), n(d)
-    {
-        assert(constantNode.find(n) == constantNode.end());
-        constantNode[n] = this;
-    }
+    using NodeType = Expr::NodeType;
+    using Operands = Expr::Operands;
 
-    Expr const* abs() const override final { return constant(std::abs(n)); }
-    Expr const* sgn() const override final { return constant(double(n > 0) - (n < 0)); }
-    Expr const* sqrt() const override final { return constant(std::sqrt(n)); }
-    Expr const* cbrt() const override final { return constant(std::cbrt(n)); }
-    Expr const* exp() const override final { return constant(std::exp(n)); }
-    Expr const* log() const override final { return constant(std::log(n)); }
-    Expr const* sin() const override final { return constant(std::sin(n)); }
-    Expr const* cos() const override final { return constant(std::cos(n)); }
-    Expr const* tan() const override final { return constant(std::tan(n)); }
-    Expr const* sec() const override final { return constant(1 / std::cos(n)); }
-    Expr const* asin() const override final { return constant(std::asin(n)); }
-    Expr const* acos() const override final { return constant(std::acos(n)); }
-    Expr const* atan() const override final { return constant(std::atan(n)); }
-    Expr const* sinh() const override final { return constant(std::sinh(n)); }
-    Expr const* cosh() const override final { return constant(std::cosh(n)); }
-    Expr const* tanh() const override final { return constant(std::tanh(n)); }
-    Expr const* sech() const override final { return constant(1 / std::cosh(n)); }
-    Expr const* asinh() const override final { return constant(std::asinh(n)); }
-    Expr const* acosh() const override final { return constant(std::acosh(n)); }
-    Expr const* atanh() const override final { return constant(std::atanh(n)); }
-    Expr const* erf() const override final { return constant(std::erf(n)); }
-    Expr const* erfc() const override final { return constant(std::erfc(n)); }
+    struct Slot
+    {
+        Expr const* node;
+        Expr const* f_x;  // The first two operands, the rest of the operands of an n-ary node are compared via 'node'
+        Expr const* g_x;
+        NodeType type;
+        uint32_t hash;
+    };
 
-    Expr const* invert() const override final { return constant(1 / n); }
-    Expr const* negate() const override final { return constant(-n); }
-    Expr const* softpp() const override final { return constant(::Spp(n)); }
-    Expr const* spence() const override final { return constant(::Li2(n)); }
-    Expr const* square() const override final { return constant(n * n); }
-    Expr const* xconic() const override final { return constant(std::sqrt(n * n - 1)); }
-    Expr const* yconic() const override final { return constant(std::sqrt(n * n + 1)); }
-    Expr const* zconic() const override final { return constant(std::sqrt(1 - n * n)); }
+    NodeTable() : slots(1024), count(0) { }
 
-    Expr const* add(Expr const*) const override final;
-    Expr const* commutative_add(Expr const*) const override final;
-    Expr const* mul(Expr const*) const override final;
-    Expr const* commutative_mul(Expr const*) const override final;
-    Expr const* pow(Expr const*) const override final;
+    Expr const* find(NodeType, Expr const*, Expr const*) const;
+    Expr const* find(NodeType, Operands) const;
+    void insert(Expr const*, NodeType, Expr const*, Expr const*);
+    void insert(Expr const*, NodeType, Operands);
+    void erase(Expr const* p, NodeType t, Expr const* f_x, Expr const* g_x) { erase(p, hash(t, f_x, g_x)); }
+    void erase(Expr const* p, NodeType t, Operands r) { erase(p, hash(t, r)); }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const&) const override final { return Clone(this); }
+    static NodeTable& instance(uint32_t);
+    static uint32_t hash(NodeType, Expr const*, Expr const*);
+    static uint32_t hash(NodeType, Operands);
 
-    bool guaranteed(Attr) const override final;
+    Mutex mutex;
 
-    bool is(NodeType t) const override final { return t == NodeType::CONSTANT; }
-    bool is(NodeType t, Expr const* p) const override final { return t == NodeType::CONSTANT && p == this; }
+private:
+    void insert(Slot const&);
+    void erase(Expr const*, uint32_t);
+    void grow();
 
-    bool easyInvert() const override final { return n != 0; }
-    bool easyNegate() const override final { return true; }
+    std::vector<Slot> slots;  // Linear probing, the size is a power of two and at most half of the slots are used
+    size_t count;
+};
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return n; }
+//----------------------------------------------------------------------------------------------------------------------
 
-    void print(std::ostream&) const override final;
+static inline uint32_t mix(uint64_t h)
+{
+    h ^= h >> 33;  // Mix the high bits down, the low bits of aligned pointers carry no information
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return uint32_t(h);
+}
 
-    virtual ~ConstantNode()
+inline uint32_t NodeTable::hash(NodeType t, Expr const* f_x, Expr const* g_x)
+{
+    uint64_t h = uint64_t(size_t(f_x)) * 0x9E3779B97F4A7C15ULL;
+    h ^= (uint64_t(size_t(g_x)) + uint64_t(t)) * 0xC2B2AE3D27D4EB4FULL;
+    return mix(h);
+}
+
+inline uint32_t NodeTable::hash(NodeType t, Operands r)
+{
+    uint64_t h = uint64_t(t) * 0xC2B2AE3D27D4EB4FULL;
+    for (auto p : r) h = (h ^ uint64_t(size_t(p))) * 0x9E3779B97F4A7C15ULL;
+    return mix(h);
+}
+
+Expr const* NodeTable::find(NodeType t, Expr const* f_x, Expr const* g_x) const
+{
+    auto const h = hash(t, f_x, g_x);
+
+    for (auto i = h & (slots.size() - 1); slots[i].node; i = (i + 1) & (slots.size() - 1))
     {
-        assert(constantNode.find(n) != constantNode.end() && constantNode[n] == this);
-        constantNode.erase(n);
+        auto& slot = slots[i];
+        if (slot.hash == h && slot.f_x == f_x && slot.g_x == g_x && slot.type == t) return slot.node;
     }
 
-private:
-    double const n;
-};
+    return nullptr;
+}
 
-//----------------------------------------------------------------------------------------------------------------------
+Expr const* NodeTable::find(NodeType t, Operands r) const
+{
+    assert(r.size() >= 2);
 
-Expr const* Expression::data::constant(double d)
+    auto const h = hash(t, r);
+    auto const same = [&](Expr const* p)
+    {
+        for (size_t n = 2; n < r.size(); ++n) if (p->operand(int(n)) != r[n]) return false;
+        return !p->operand(int(r.size()));
+    };
+
+    for (auto i = h & (slots.size() - 1); slots[i].node; i = (i + 1) & (slots.size() - 1))
+    {
+        auto& slot = slots[i];
+        if (slot.hash == h && slot.f_x == r[0] && slot.g_x == r[1] && slot.type == t && same(slot.node)) return slot.node;
+    }
+
+    return nullptr;
+}
+
+void NodeTable::insert(Expr const* p, NodeType t, Expr const* f_x, Expr const* g_x)
 {
-    if (isnan(d)) return Clone(Nan::instance);
+    insert({ p, f_x, g_x, t, hash(t, f_x, g_x) });
+}
 
-    auto node = constantNode.find(d);
-    return node != constantNode.end() ? Clone(node->second) : new ConstantNode(d);
+void NodeTable::insert(Expr const* p, NodeType t, Operands r)
+{
+    insert({ p, r[0], r[1], t, hash(t, r) });
 }
 
-/***********************************************************************************************************************
-*** VariableNode
-***********************************************************************************************************************/
+void NodeTable::insert(Slot const& r)
+{
+    if (2 * (count + 1) > slots.size()) grow();
 
-struct VariableNode final : public Expr, private ObjectGuard<VariableNode>
+    auto i = r.hash & (slots.size() - 1);
+    while (slots[i].node) i = (i + 1) & (slots.size() - 1);
+
+    slots[i] = r;
+    ++count;
+}
+
+void NodeTable::erase(Expr const* p, uint32_t h)
 {
-    explicit VariableNode(Variable const& r) : Expr(1), x(r)
+    auto const mask = slots.size() - 1;
+    auto i = h & mask;
+
+    while (slots[i].node != p)
     {
-        assert(variableNode.find(x.id()) == variableNode.end());
-        variableNode[x.id()] = this;
+        assert(slots[i].node);
+        i = (i + 1) & mask;
     }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final
+    // Backward shift deletion: move the following items of the probe sequence up so that no tombstones are needed
+
+    for (auto j = (i + 1) & mask; slots[j].node; j = (j + 1) & mask)
     {
-        for (auto& item : r)
+        auto const k = slots[j].hash & mask;
+
+        if (((j - k) & mask) >= ((j - i) & mask))  // The home of item 'j' is not within '(i, j]' so it may fill slot 'i'
         {
-            if (item.first.id() == x.id())
-            {
-                return Clone(item.second);
-            }
+            slots[i] = slots[j];
+            i = j;
         }
-
-        return Clone(this);
     }
 
-    bool guaranteed(Attr) const override final;
+    slots[i].node = nullptr;
+    --count;
+}
 
-    bool is(NodeType t) const override final { return t == NodeType::VARIABLE; }
-    bool is(NodeType t, Expr const* p) const override final { return t == NodeType::VARIABLE && p == this; }
+void NodeTable::grow()
+{
+    std::vector<Slot> old(2 * slots.size());
+    old.swap(slots);
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return double(x); }
+    for (auto& slot : old) if (slot.node)
+    {
+        auto i = slot.hash & (slots.size() - 1);
+        while (slots[i].node) i = (i + 1) & (slots.size() - 1);
+        slots[i] = slot;
+    }
+}
 
-    void print(std::ostream&) const override final;
+NodeTable& NodeTable::instance(uint32_t h)
+{
+    // Never destroyed, so that nodes can be released by the destructors of statics.  With several threads the nodes are
+    // striped over separately locked tables by the high bits of their hash, the low bits index the slots of the table.
 
-private:
-    virtual ~VariableNode()
+#if defined(LASKENTA_THREADS)
+    static int const STRIPES = 6;
+    static auto const table = new NodeTable[1 << STRIPES];
+    return table[h >> (32 - STRIPES)];
+#else
+    static auto& table = *new NodeTable;
+    static_cast<void>(h);  // The one table has all the hashes
+    return table;
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct Claim final  // Of a node by its key: the node cloned, or else the key locked until the new node has been created
+{
+    template <typename Find> Claim(Mutex& r, Find find) : lock(r, std::defer_lock), node(nullptr)
     {
-        assert(variableNode.find(x.id()) != variableNode.end() && variableNode[x.id()] == this);
-        variableNode.erase(x.id());
+        // A node that another thread is deleting is found until its destructor has removed it from the table, and its
+        // key cannot be entered again until then
+
+        for (;;)
+        {
+            lock.lock();
+
+            auto const p = find();
+            if (!p) return;
+
+#if defined(LASKENTA_THREADS)
+            node = Shared::CloneLive(p);
+#else
+            node = Shared::Clone(p);
+#endif
+            lock.unlock();
+            if (node) return;
+
+#if defined(LASKENTA_THREADS)
+            std::this_thread::yield();
+#endif
+        }
     }
 
-    Variable const x;
+    std::unique_lock<Mutex> lock;
+    Expr const* node;
 };
 
 //----------------------------------------------------------------------------------------------------------------------
 
-Expr const* Expression::data::variable(Variable const& r)
+inline Mutex& Expression::data::stripe(NodeType t, Expr const* f_x, Expr const* g_x)
 {
-    auto node = variableNode.find(r.id());
-    return node != variableNode.end() ? Clone(node->second) : new VariableNode(r);
+    return NodeTable::instance(NodeTable::hash(t, f_x, g_x)).mutex;
 }
 
-/***********************************************************************************************************************
-*** Abs
-***********************************************************************************************************************/
+inline Mutex& Expression::data::stripe(NodeType t, Operands r)
+{
+    return NodeTable::instance(NodeTable::hash(t, r)).mutex;
+}
 
-struct Abs final : public FunctionNode, private ObjectGuard<Abs>
+inline Expr const* Expression::data::lookup(NodeType t, Expr const* f_x, Expr const* g_x)
 {
-    Abs(Expr const* p) : FunctionNode(p, NodeType::ABS) { }
+    auto& table = NodeTable::instance(NodeTable::hash(t, f_x, g_x));
+    Guard guard(table.mutex);
+    return table.find(t, f_x, g_x);
+}
 
-    Expr const* abs() const override final { return Clone(this); }
-    Expr const* sgn() const override final { auto step0 = f_x->sgn(); auto step1 = step0->abs(); Erase(step0); return step1; }
-    Expr const* cbrt() const override final { auto step0 = f_x->cbrt(); auto step1 = step0->abs(); Erase(step0); return step1; }
-    Expr const* cos() const override final { return f_x->cos(); }
-    Expr const* sec() const override final { return f_x->sec(); }
-    Expr const* asin() const override final { auto step0 = f_x->asin(); auto step1 = step0->abs(); Erase(step0); return step1; }
-    Expr const* atan() const override final { auto step0 = f_x->atan(); auto step1 = step0->abs(); Erase(step0); return step1; }
-    Expr const* sinh() const override final { auto step0 = f_x->sinh(); auto step1 = step0->abs(); Erase(step0); return step1; }
-    Expr const* cosh() const override final { return f_x->cosh(); }
-    Expr const* tanh() const override final { auto step0 = f_x->tanh(); auto step1 = step0->abs(); Erase(step0); return step1; }
-    Expr const* sech() const override final { return f_x->sech(); }
-    Expr const* asinh() const override final { auto step0 = f_x->asinh(); auto step1 = step0->abs(); Erase(step0); return step1; }
-    Expr const* atanh() const override final { auto step0 = f_x->atanh(); auto step1 = step0->abs(); Erase(step0); return step1; }
-    Expr const* erf() const override final { auto step0 = f_x->erf(); auto step1 = step0->abs(); Erase(step0); return step1; }
-    Expr const* square() const override final { return f_x->square(); }
-    Expr const* xconic() const override final { return f_x->xconic(); }
-    Expr const* yconic() const override final { return f_x->yconic(); }
-    Expr const* zconic() const override final { return f_x->zconic(); }
+inline Expr const* Expression::data::lookup(NodeType t, Operands r)
+{
+    auto& table = NodeTable::instance(NodeTable::hash(t, r));
+    Guard guard(table.mutex);
+    return table.find(t, r);
+}
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->abs(); Erase(step0); return step1; }
+inline void Expression::data::enter(Expr const* p, NodeType t, Expr const* f_x, Expr const* g_x)
+{
+    auto& table = NodeTable::instance(NodeTable::hash(t, f_x, g_x));
+    Guard guard(table.mutex);
+    assert(!table.find(t, f_x, g_x));
+    table.insert(p, t, f_x, g_x);
+}
 
-    bool guaranteed(Attr) const override final;
+inline void Expression::data::enter(Expr const* p, NodeType t, Operands r)
+{
+    auto& table = NodeTable::instance(NodeTable::hash(t, r));
+    Guard guard(table.mutex);
+    assert(!table.find(t, r));
+    table.insert(p, t, r);
+}
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::abs(f_x->evaluate()); }
+inline void Expression::data::leave(Expr const* p, NodeType t, Expr const* f_x, Expr const* g_x)
+{
+    auto& table = NodeTable::instance(NodeTable::hash(t, f_x, g_x));
+    Guard guard(table.mutex);
+    table.erase(p, t, f_x, g_x);
+}
 
-    void print(std::ostream&) const override final;
-};
+inline void Expression::data::leave(Expr const* p, NodeType t, Operands r)
+{
+    auto& table = NodeTable::instance(NodeTable::hash(t, r));
+    Guard guard(table.mutex);
+    table.erase(p, t, r);
+}
 
 /***********************************************************************************************************************
-*** Sgn
+*** Memo
 ***********************************************************************************************************************/
 
-struct Sgn final : public FunctionNode, private ObjectGuard<Sgn>
+struct Expression::data::Memo final  // What has been found out about a node: its derivatives, attributes and range
 {
-    Sgn(Expr const* p) : FunctionNode(p, NodeType::SGN) { }
+    // A derivative is remembered for as long as both the node and the derivative exist.  A constant cannot refer back
+    // to the node, so it is held.  Any other derivative may, that of 'exp(x)' for one, and holding it would keep both
+    // alive forever.  Instead it keeps a back reference so that the entry is forgotten as soon as either one is deleted.
+    // NOTE: Variable ids are addresses that may be reused, but by then no node left can depend on the earlier variable.
 
-    Expr const* sgn() const override final { return Clone(this); }
-    Expr const* cbrt() const override final { return Clone(this); }
-    Expr const* square() const override final { auto step0 = f_x->square(); auto step1 = step0->sgn(); Erase(step0); return step1; }
+    Memo() : inferred(0), attributes(0), bounds{ -HUGE_VAL, HUGE_VAL }, bounded(false) { }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sgn(); Erase(step0); return step1; }
+    struct Entry
+    {
+        size_t id;
+        Expr const* node;
+        bool held;
+    };
 
-    bool guaranteed(Attr) const override final;
+    using Source = std::pair<Expr const*, size_t>;
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { auto x = f_x->evaluate(); return double(x > 0) - (x < 0); }
+    void* operator new(size_t n) { return n <= NodePool::LARGEST ? NodePool::instance(n).allocate() : ::operator new(n); }
+    void operator delete(void* p, size_t n) { if (n <= NodePool::LARGEST) NodePool::instance(n).release(p); else ::operator delete(p); }
 
-    void print(std::ostream&) const override final;
-};
+    std::vector<Entry, NodePool::Allocator<Entry>>::iterator find(size_t id)
+    {
+        return std::lower_bound(by.begin(), by.end(), id, [](Entry const& r, size_t n) { return r.id < n; });
+    }
 
-/***********************************************************************************************************************
-*** Sqrt
-***********************************************************************************************************************/
+    std::vector<Entry, NodePool::Allocator<Entry>> by;  // Derivatives sorted by the variable
+    std::vector<Source, NodePool::Allocator<Source>> of;  // Nodes that this is the derivative of
 
-struct Sqrt final : public FunctionNode, private ObjectGuard<Sqrt>
-{
-    Sqrt(Expr const* p) : FunctionNode(p, NodeType::SQRT) { }
+    uint32_t inferred;  // Bits of the attributes already inferred
+    uint32_t attributes;  // Bits of those that are guaranteed
 
-    Expr const* abs() const override final { return Clone(this); }
-    Expr const* square() const override final { return Clone(f_x); }
-    Expr const* pow(Expr const* p) const override final;
+    Interval bounds;  // See 'range()'
+    bool bounded;
+};
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sqrt(); Erase(step0); return step1; }
+//----------------------------------------------------------------------------------------------------------------------
 
-    bool guaranteed(Attr) const override final;
+static Mutex& memos()  // Of the memo records of all the nodes, since remembering links the records of two nodes
+{
+    static auto& mutex = *new Mutex;
+    return mutex;
+}
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::sqrt(f_x->evaluate()); }
+Expr const* Expression::data::recall(size_t id) const
+{
+    // Cloned while the records are locked, since a derivative that is not held may be being deleted by another thread.
+    // Then it is waited to be forgotten, and derived again.
 
-    void print(std::ostream&) const override final;
-};
+    Claim claim(memos(), [this, id]() -> Expr const*
+    {
+        if (!memo) return nullptr;
 
-/***********************************************************************************************************************
-*** Cbrt
-***********************************************************************************************************************/
+        auto item = memo->find(id);
+        return item != memo->by.end() && item->id == id ? item->node : nullptr;
+    });
 
-struct Cbrt final : public FunctionNode, private ObjectGuard<Cbrt>
+    return claim.node;
+}
+
+void Expression::data::remember(size_t id, Expr const* d) const
 {
-    Cbrt(Expr const* p) : FunctionNode(p, NodeType::CBRT) { }
+    Guard guard(memos());
+    auto const held = d->type() == NodeType::CONSTANT;
 
-    Expr const* sgn() const override final { return f_x->sgn(); }
-    Expr const* pow(Expr const*) const override final;
+    if (!memo) memo = new Memo;
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->cbrt(); Erase(step0); return step1; }
+    auto item = memo->find(id);
+    if (item != memo->by.end() && item->id == id) return;  // Derived by another thread as well, which remembered it first
+    memo->by.insert(item, { id, held ? Clone(d) : d, held });
 
-    bool guaranteed(Attr) const override final;
+    if (held || d == this) return;
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::cbrt(f_x->evaluate()); }
+    if (!d->memo) d->memo = new Memo;
+    d->memo->of.emplace_back(this, id);
+}
 
-    void print(std::ostream&) const override final;
-};
+void Expression::data::forget() const
+{
+    Guard guard(memos());
+    for (auto& r : memo->by)
+    {
+        if (r.held)
+        {
+            Erase(r.node);
+        }
+        else if (r.node != this)
+        {
+            auto& of = r.node->memo->of;
+            auto item = std::find(of.begin(), of.end(), Memo::Source(this, r.id));
+            *item = of.back();
+            of.pop_back();
+        }
+    }
 
-/***********************************************************************************************************************
-*** Exp
-***********************************************************************************************************************/
+    for (auto& r : memo->of)
+    {
+        auto& by = r.first->memo->by;
+        by.erase(r.first->memo->find(r.second));
+    }
 
-struct Exp final : public FunctionNode, private ObjectGuard<Exp>
+    delete memo;
+    memo = nullptr;
+}
+
+bool Expression::data::guaranteed(Attr a) const
 {
-    Exp(Expr const* p) : FunctionNode(p, NodeType::EXP) { }
+    // Inferring an attribute may ask several attributes of each operand, which repeats all the way down unless the
+    // answers are remembered.  So all of the attributes of the operands are inferred first, bottom up as 'range()'
+    // does, and each 'attribute()' then finds those of its operands remembered without recursing any deeper.
 
-    Expr const* abs() const override final { return Clone(this); }
-    Expr const* sgn() const override final { return constant(1); }
-    Expr const* log() const override final { return Clone(f_x); }
-    Expr const* pow(Expr const* p) const override final { auto step0 = f_x->mul(p); auto step1 = step0->exp();  Erase(step0); return step1; }
+    static uint32_t const ALL = (2u << int(Attr::BOUNDEDBELOW)) - 1;
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->exp(); Erase(step0); return step1; }
+    auto const bit = 1u << int(a);
 
-    bool guaranteed(Attr) const override final;
+    auto const infer = [](Expr const* p, Attr b)
+    {
+        auto const bit = 1u << int(b);
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::exp(f_x->evaluate()); }
+        if (!p->memo) p->memo = new Memo;
+        if (p->memo->inferred & bit) return;
 
-    void print(std::ostream&) const override final;
-};
+        if (p->attribute(b) || p->implied(b)) p->memo->attributes |= bit;
+        p->memo->inferred |= bit;
+    };
 
-/***********************************************************************************************************************
-*** ExpM1
-***********************************************************************************************************************/
+    Guard guard(memos());
 
-struct ExpM1 final : public FunctionNode, private ObjectGuard<ExpM1>
-{
-    ExpM1(Expr const* p) : FunctionNode(p, NodeType::EXPM1) { }
+    if (!memo || !(memo->inferred & bit))
+    {
+        postorder(this, [this](Expr const* p)
+        {
+            return p != this && p->memo && p->memo->inferred == ALL;
+        }, [this, &infer](Expr const* p)
+        {
+            if (p != this) for (int b = 0; b <= int(Attr::BOUNDEDBELOW); ++b) infer(p, Attr(b));
+        });
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->expm1(); Erase(step0); return step1; }
+        infer(this, a);
+    }
 
-    bool guaranteed(Attr) const override final;
+    return (memo->attributes & bit) != 0;
+}
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::expm1(f_x->evaluate()); }
+Expr::Interval Expression::data::range() const
+{
+    // Each node bounds its values by the ranges of its operands, so they are propagated up from the variables once
 
-    void print(std::ostream&) const override final;
-};
+    Guard guard(memos());
 
-/***********************************************************************************************************************
-*** Log
-***********************************************************************************************************************/
+    if (!memo || !memo->bounded) postorder(this, [](Expr const* p)
+    {
+        return p->memo && p->memo->bounded;
+    }, [](Expr const* p)
+    {
+        auto r = p->interval();
+        if (!(r.lo <= r.hi)) r = { -HUGE_VAL, HUGE_VAL };  // Not defined anywhere, or 'nan' at either end
 
-struct Log final : public FunctionNode, private ObjectGuard<Log>
+        if (!p->memo) p->memo = new Memo;
+        p->memo->bounds = r;
+        p->memo->bounded = true;
+    });
+
+    return memo->bounds;
+}
+
+bool Expression::data::implied(Attr a) const
 {
-    Log(Expr const* p) : FunctionNode(p, NodeType::LOG) { }
+    // The range is found cheaply, so it is checked before the definedness, which is inferred bottom up first so that
+    // asking it does not recurse all the way down a deep graph
 
-    Expr const* exp() const override final { return Clone(f_x); }
+    auto const r = range();
+    auto holds = false;
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->log(); Erase(step0); return step1; }
+    switch (a)
+    {
+    case Attr::NONZERO: holds = r.lo > 0 || r.hi < 0; break;
+    case Attr::POSITIVE: holds = r.lo > 0; break;
+    case Attr::NEGATIVE: holds = r.hi < 0; break;
+    case Attr::NONPOSITIVE: holds = r.hi <= 0; break;
+    case Attr::NONNEGATIVE: holds = r.lo >= 0; break;
+    case Attr::UNITRANGE: holds = r.lo >= -1 && r.hi <= 1; break;
+    case Attr::ANTIUNITRANGE: holds = r.lo > 1 || r.hi < -1; break;
+    case Attr::OPENUNITRANGE: holds = r.lo > -1 && r.hi < 1; break;
+    case Attr::ANTIOPENUNITRANGE: holds = r.lo >= 1 || r.hi <= -1; break;
+    case Attr::BOUNDEDABOVE: holds = r.hi < HUGE_VAL; break;
+    case Attr::BOUNDEDBELOW: holds = r.lo > -HUGE_VAL; break;
+    default: break;  // Not a matter of the range alone
+    }
 
-    bool guaranteed(Attr) const override final;
+    if (!holds) return false;
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::log(f_x->evaluate()); }
+    postorder(this, [](Expr const* p)
+    {
+        return p->memo && p->memo->inferred & 1u << int(Attr::DEFINED);
+    }, [](Expr const* p)
+    {
+        p->guaranteed(Attr::DEFINED);
+    });
 
-    void print(std::ostream&) const override final;
-};
+    return guaranteed(Attr::DEFINED);
+}
 
-/***********************************************************************************************************************
-*** Log1P
-***********************************************************************************************************************/
+//----------------------------------------------------------------------------------------------------------------------
 
-struct Log1P final : public FunctionNode, private ObjectGuard<Log1P>
+Expression::data::~data()
 {
-    Log1P(Expr const* p) : FunctionNode(p, NodeType::LOG1P) { }
+    if (memo) forget();
+}
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->log1p(); Erase(step0); return step1; }
+Expr const* Expression::data::derive(Variable const& r) const
+{
+    // Within a derivation 'cached()' holds the derivatives, as it does for 'bind()'.  They are also remembered by the
+    // nodes for the later derivations, such as those by the other variables and those of higher orders.  A subgraph is
+    // not entered at all if the bit of the variable is clear in its 'dependencies', as its derivative is then 0.
 
-    bool guaranteed(Attr) const override final;
+    if (!cached())
+    {
+        auto const v = r.id();
+        auto const m = dependency(r);
+        auto const zero = constant(0);
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::log1p(f_x->evaluate()); }
+        postorder(this, [v, m, zero](Expr const* p)
+        {
+            auto& node = p->cached();
+            if (!node) node = p->dependencies & m ? p->recall(v) : Clone(zero);
+            return node != nullptr;
+        }, [&r, v](Expr const* p)
+        {
+            auto const node = p->derivative(r);
+            p->cached() = node;
+            p->remember(v, node);
+        });
 
-    void print(std::ostream&) const override final;
-};
+        Erase(zero);
+    }
+
+    return Clone(cached());
+}
 
 /***********************************************************************************************************************
-*** Sin
+*** FunctionNode
 ***********************************************************************************************************************/
 
-struct Sin final : public FunctionNode, private ObjectGuard<Sin>
+struct FunctionNode : public Expr
 {
-    Sin(Expr const* p) : FunctionNode(p, NodeType::SIN) { }
+    FunctionNode(Expr const* p, NodeType n) : Expr(p->depth + 1, p->dependencies), f_x(p), fn(n)
+    {
+        enter(this, fn, f_x);
+    }
 
-    Expr const* zconic() const override final { auto step0 = f_x->cos(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    bool is(NodeType t) const override final { return t == fn; }
+    bool is(NodeType t, Expr const* p) const override final { return t == fn && p == f_x; }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sin(); Erase(step0); return step1; }
+    NodeType type() const override final { return fn; }
+    Expr const* operand(int i) const override final { return i == 0 ? f_x : nullptr; }
 
-    bool guaranteed(Attr) const override final;
+    Interval interval() const override final;
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::sin(f_x->evaluate()); }
+protected:
+    virtual ~FunctionNode()
+    {
+        assert(lookup(fn, f_x) == this);
+        leave(this, fn, f_x);
+        Erase(f_x);
+    }
+
+    Expr const* const f_x;
 
-    void print(std::ostream&) const override final;
+private:
+    NodeType const fn;
 };
 
 /***********************************************************************************************************************
-*** Cos
+*** OperatorNode
 ***********************************************************************************************************************/
 
-struct Cos final : public FunctionNode, private ObjectGuard<Cos>
+struct OperatorNode : public Expr
 {
-    Cos(Expr const* p) : FunctionNode(p, NodeType::COS) { }
+    OperatorNode(Expr const* p, Expr const* q) : Expr(std::max(p->depth, q->depth) + 1, p->dependencies | q->dependencies), f_x(p), g_x(q) { }
 
-    Expr const* invert() const override final { return f_x->sec(); }
-    Expr const* zconic() const override final { auto step0 = f_x->sin(); auto step1 = step0->abs(); Erase(step0); return step1; }
-
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->cos(); Erase(step0); return step1; }
+    bool is(NodeType, Expr const*) const override final { return false; }
 
-    bool guaranteed(Attr) const override final;
+    Expr const* operand(int i) const override final { return i == 0 ? f_x : i == 1 ? g_x : nullptr; }
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::cos(f_x->evaluate()); }
+protected:
+    virtual ~OperatorNode()
+    {
+        Erase(f_x);
+        Erase(g_x);
+    }
 
-    void print(std::ostream&) const override final;
+    Expr const* const f_x;
+    Expr const* const g_x;
 };
 
 /***********************************************************************************************************************
-*** Tan
+*** ListNode
 ***********************************************************************************************************************/
 
-struct Tan final : public FunctionNode, private ObjectGuard<Tan>
+struct ListNode : public Expr  // N-ary operator, see 'sum()' and 'product()'
 {
-    Tan(Expr const* p) : FunctionNode(p, NodeType::TAN) { }
+    explicit ListNode(Terms const& r) : Expr(height(r), dependency(r)), terms(copy(r), r.size())
+    {
+        for (auto p : terms) Clone(p);
+    }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->tan(); Erase(step0); return step1; }
+    bool is(NodeType, Expr const*) const override final { return false; }
 
-    bool guaranteed(Attr) const override final;
+    Expr const* operand(int i) const override final { return size_t(i) < terms.size() ? terms[i] : nullptr; }
+    size_t size() const { return terms.size(); }
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::tan(f_x->evaluate()); }
+    static size_t const MAXTERMS = 64;  // Nested operators are not flattened beyond this
+
+    static bool precedes(Expr const* p, Expr const* q)  // Order of the terms, ties (after wraparound) broken by address
+    {
+        return p->serial != q->serial ? p->serial < q->serial : std::less<Expr const*>()(p, q);
+    }
+
+protected:
+    virtual ~ListNode()
+    {
+        for (auto p : terms) Erase(p);
+        NodePool::Allocator<Expr const*>().deallocate(const_cast<Expr const**>(terms.begin()), terms.size());
+    }
+
+    Operands const terms;  // Sorted by 'precedes()', except the constant (if any) of 'sum()' and 'product()'
+
+private:
+    static Expr const* const* copy(Terms const& r)  // A block of its own instead of 'Terms', so the node is smaller
+    {
+        auto p = NodePool::Allocator<Expr const*>().allocate(r.size());
+        std::copy(r.begin(), r.end(), p);
+        return p;
+    }
+
+    static int32_t height(Terms const& r)
+    {
+        int32_t n = 0;
+        for (auto p : r) n = std::max(n, p->depth);
+        return n + 1;
+    }
 
-    void print(std::ostream&) const override final;
+    static uint64_t dependency(Terms const& r)
+    {
+        uint64_t m = 0;
+        for (auto p : r) m |= p->dependencies;
+        return m;
+    }
 };
 
 /***********************************************************************************************************************
-*** Sec
+*** Nan
 ***********************************************************************************************************************/
 
-struct Sec final : public FunctionNode, private ObjectGuard<Sec>
+struct Nan final : public Expr
 {
-    Sec(Expr const* p) : FunctionNode(p, NodeType::SEC) { }
+    static Nan const instance;
 
-    Expr const* invert() const override final { return f_x->cos(); }
+    Expr const* abs() const override final { return Clone(this); }
+    Expr const* sgn() const override final { return Clone(this); }
+    Expr const* sqrt() const override final { return Clone(this); }
+    Expr const* cbrt() const override final { return Clone(this); }
+    Expr const* exp() const override final { return Clone(this); }
+    Expr const* expm1() const override final { return Clone(this); }
+    Expr const* log() const override final { return Clone(this); }
+    Expr const* log1p() const override final { return Clone(this); }
+    Expr const* sin() const override final { return Clone(this); }
+    Expr const* cos() const override final { return Clone(this); }
+    Expr const* tan() const override final { return Clone(this); }
+    Expr const* sec() const override final { return Clone(this); }
+    Expr const* asin() const override final { return Clone(this); }
+    Expr const* acos() const override final { return Clone(this); }
+    Expr const* atan() const override final { return Clone(this); }
+    Expr const* sinh() const override final { return Clone(this); }
+    Expr const* cosh() const override final { return Clone(this); }
+    Expr const* tanh() const override final { return Clone(this); }
+    Expr const* sech() const override final { return Clone(this); }
+    Expr const* asinh() const override final { return Clone(this); }
+    Expr const* acosh() const override final { return Clone(this); }
+    Expr const* atanh() const override final { return Clone(this); }
+    Expr const* erf() const override final { return Clone(this); }
+    Expr const* erfc() const override final { return Clone(this); }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sec(); Erase(step0); return step1; }
+    Expr const* invert() const override final { return Clone(this); }
+    Expr const* negate() const override final { return Clone(this); }
+    Expr const* softpp() const override final { return Clone(this); }
+    Expr const* spence() const override final { return Clone(this); }
+    Expr const* square() const override final { return Clone(this); }
+    Expr const* xconic() const override final { return Clone(this); }
+    Expr const* yconic() const override final { return Clone(this); }
+    Expr const* zconic() const override final { return Clone(this); }
 
-    bool guaranteed(Attr) const override final;
+    Expr const* add(Expr const*) const override final { return Clone(this); }
+    Expr const* commutative_add(Expr const*) const override final { return Clone(this); }
+    Expr const* mul(Expr const*) const override final { return Clone(this); }
+    Expr const* commutative_mul(Expr const*) const override final { return Clone(this); }
+    Expr const* pow(Expr const*) const override final { return Clone(this); }
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return 1 / std::cos(f_x->evaluate()); }
+    Expr const* binding(Substitution const&) const override final { return Clone(this); }
 
-    void print(std::ostream&) const override final;
-};
+    bool attribute(Attr) const override final { return false; }
 
-/***********************************************************************************************************************
-*** ASin
-***********************************************************************************************************************/
+    bool is(NodeType) const override final { return false; }
+    bool is(NodeType, Expr const*) const override final { return false; }
 
-struct ASin final : public FunctionNode, private ObjectGuard<ASin>
-{
-    ASin(Expr const* p) : FunctionNode(p, NodeType::ASIN) { }
+    NodeType type() const override final { return NodeType::CONSTANT; }  // Compiles into a constant 'nan'
 
-    Expr const* sgn() const override final { return f_x->sgn(); }
-    Expr const* sin() const override final { return Clone(f_x); }
-    Expr const* cos() const override final { return f_x->zconic(); }
-    Expr const* sec() const override final { auto step0 = f_x->zconic(); auto step1 = step0->invert(); Erase(step0); return step1; }
+    Expr const* derivative(Variable const&) const override final { return Clone(this); }
+    double value() const override final { return nan(__FUNCTION__); }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->asin(); Erase(step0); return step1; }
+    void print(std::ostream& out, std::vector<Token>&) const override final { out << "nan"; }
 
-    bool guaranteed(Attr) const override final;
+private:
+    Nan() : Expr(0, ~0ULL) { }  // Depends on every variable, so that its derivative is 'nan' instead of 0
+};
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::asin(f_x->evaluate()); }
+//----------------------------------------------------------------------------------------------------------------------
 
-    void print(std::ostream&) const override final;
-};
+Nan const Nan::instance;
 
 /***********************************************************************************************************************
-*** ACos
+*** ConstantNode
 ***********************************************************************************************************************/
 
-struct ACos final : public FunctionNode, private ObjectGuard<ACos>
+struct ConstantNode final : public Expr, private ObjectGuard<ConstantNode>
 {
-    ACos(Expr const* p) : FunctionNode(p, NodeType::ACOS) { }
+    explicit ConstantNode(double d) : Expr(0, 0), n(d)
+    {
+        Guard guard(leaves());
+        assert(constantNode.find(n) == constantNode.end());
+        constantNode[n] = this;
+    }
 
-    Expr const* abs() const override final { return Clone(this); }
-    Expr const* sin() const override final { return f_x->zconic(); }
-    Expr const* cos() const override final { return Clone(f_x); }
-    Expr const* sec() const override final { return f_x->invert(); }
+    Expr const* abs() const override final { return constant(std::abs(n)); }
+    Expr const* sgn() const override final { return constant(double(n > 0) - (n < 0)); }
+    Expr const* sqrt() const override final { return constant(std::sqrt(n)); }
+    Expr const* cbrt() const override final { return constant(std::cbrt(n)); }
+    Expr const* exp() const override final { return constant(std::exp(n)); }
+    Expr const* log() const override final { return constant(std::log(n)); }
+    Expr const* sin() const override final { return constant(std::sin(n)); }
+    Expr const* cos() const override final { return constant(std::cos(n)); }
+    Expr const* tan() const override final { return constant(std::tan(n)); }
+    Expr const* sec() const override final { return constant(1 / std::cos(n)); }
+    Expr const* asin() const override final { return constant(std::asin(n)); }
+    Expr const* acos() const override final { return constant(std::acos(n)); }
+    Expr const* atan() const override final { return constant(std::atan(n)); }
+    Expr const* sinh() const override final { return constant(std::sinh(n)); }
+    Expr const* cosh() const override final { return constant(std::cosh(n)); }
+    Expr const* tanh() const override final { return constant(std::tanh(n)); }
+    Expr const* sech() const override final { return constant(1 / std::cosh(n)); }
+    Expr const* asinh() const override final { return constant(std::asinh(n)); }
+    Expr const* acosh() const override final { return constant(std::acosh(n)); }
+    Expr const* atanh() const override final { return constant(std::atanh(n)); }
+    Expr const* erf() const override final { return constant(std::erf(n)); }
+    Expr const* erfc() const override final { return constant(std::erfc(n)); }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->acos(); Erase(step0); return step1; }
+    Expr const* invert() const override final { return constant(1 / n); }
+    Expr const* negate() const override final { return constant(-n); }
+    Expr const* softpp() const override final { return constant(::Spp(n)); }
+    Expr const* spence() const override final { return constant(::Li2(n)); }
+    Expr const* square() const override final { return constant(n * n); }
+    Expr const* xconic() const override final { return constant(std::sqrt(n * n - 1)); }
+    Expr const* yconic() const override final { return constant(std::sqrt(n * n + 1)); }
+    Expr const* zconic() const override final { return constant(std::sqrt(1 - n * n)); }
 
-    bool guaranteed(Attr) const override final;
+    Expr const* add(Expr const*) const override final;
+    Expr const* commutative_add(Expr const*) const override final;
+    Expr const* mul(Expr const*) const override final;
+    Expr const* commutative_mul(Expr const*) const override final;
+    Expr const* pow(Expr const*) const override final;
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::acos(f_x->evaluate()); }
+    Expr const* binding(Substitution const&) const override final { return Clone(this); }
 
-    void print(std::ostream&) const override final;
-};
+    bool attribute(Attr) const override final;
+    Interval interval() const override final { return { n, n }; }
 
-/***********************************************************************************************************************
-*** ATan
-***********************************************************************************************************************/
+    bool is(NodeType t) const override final { return t == NodeType::CONSTANT; }
+    bool is(NodeType t, Expr const* p) const override final { return t == NodeType::CONSTANT && p == this; }
 
-struct ATan final : public FunctionNode, private ObjectGuard<ATan>
-{
-    ATan(Expr const* p) : FunctionNode(p, NodeType::ATAN) { }
+    NodeType type() const override final { return NodeType::CONSTANT; }
 
-    Expr const* sgn() const override final { return f_x->sgn(); }
-    Expr const* cos() const override final { auto step0 = f_x->yconic(); auto step1 = step0->invert(); Erase(step0); return step1; }
-    Expr const* tan() const override final { return Clone(f_x); }
-    Expr const* sec() const override final { return f_x->yconic(); }
+    bool easyInvert() const override final { return n != 0; }
+    bool easyNegate() const override final { return true; }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->atan(); Erase(step0); return step1; }
+    Expr const* derivative(Variable const&) const override final;
+    double value() const override final { return n; }
 
-    bool guaranteed(Attr) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::atan(f_x->evaluate()); }
+    virtual ~ConstantNode()
+    {
+        Guard guard(leaves());
+        assert(constantNode.find(n) != constantNode.end() && constantNode[n] == this);
+        constantNode.erase(n);
+    }
 
-    void print(std::ostream&) const override final;
+private:
+    double const n;
 };
 
+//----------------------------------------------------------------------------------------------------------------------
+
+Expr const* Expression::data::constant(double d)
+{
+    if (isnan(d)) return Clone(Nan::instance);
+
+    Claim claim(leaves(), [d] { auto node = constantNode.find(d); return node != constantNode.end() ? node->second : nullptr; });
+    return claim.node ? claim.node : new ConstantNode(d);
+}
+
 /***********************************************************************************************************************
-*** SinH
+*** VariableNode
 ***********************************************************************************************************************/
 
-struct SinH final : public FunctionNode, private ObjectGuard<SinH>
+struct VariableNode final : public Expr, private ObjectGuard<VariableNode>
 {
-    SinH(Expr const* p) : FunctionNode(p, NodeType::SINH) { }
+    explicit VariableNode(Variable const& r) : Expr(1, dependency(r)), x(r)
+    {
+        Guard guard(leaves());
+        assert(variableNode.find(x.id()) == variableNode.end());
+        variableNode[x.id()] = this;
+    }
 
-    Expr const* sgn() const override final { return f_x->sgn(); }
-    Expr const* asinh() const override final { return Clone(f_x); }
-    Expr const* yconic() const override final { return f_x->cosh(); }
+    Expr const* binding(Substitution const& r) const override final
+    {
+        auto item = r.find(x.id());
+        return Clone(item != r.end() ? item->second : this);
+    }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sinh(); Erase(step0); return step1; }
+    bool attribute(Attr) const override final;
+    Interval interval() const override final { auto r = x.Range(); return { r.first, r.second }; }
 
-    bool guaranteed(Attr) const override final;
+    bool is(NodeType t) const override final { return t == NodeType::VARIABLE; }
+    bool is(NodeType t, Expr const* p) const override final { return t == NodeType::VARIABLE && p == this; }
+
+    NodeType type() const override final { return NodeType::VARIABLE; }
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::sinh(f_x->evaluate()); }
+    double value() const override final { return double(x); }
+
+    void print(std::ostream&, std::vector<Token>&) const override final;
+
+private:
+    friend struct CompiledExpression::data;
+    friend struct Expression;
+
+    virtual ~VariableNode()
+    {
+        Guard guard(leaves());
+        assert(variableNode.find(x.id()) != variableNode.end() && variableNode[x.id()] == this);
+        variableNode.erase(x.id());
+    }
 
-    void print(std::ostream&) const override final;
+    Variable const x;
 };
 
+//----------------------------------------------------------------------------------------------------------------------
+
+Expr const* Expression::data::variable(Variable const& r)
+{
+    Claim claim(leaves(), [&r] { auto node = variableNode.find(r.id()); return node != variableNode.end() ? node->second : nullptr; });
+    return claim.node ? claim.node : new VariableNode(r);
+}
+
 /***********************************************************************************************************************
-*** CosH
+*** Abs
 ***********************************************************************************************************************/
 
-struct CosH final : public FunctionNode, private ObjectGuard<CosH>
+struct Abs final : public FunctionNode, private ObjectGuard<Abs>
 {
-    CosH(Expr const* p) : FunctionNode(p, NodeType::COSH) { }
+    Abs(Expr const* p) : FunctionNode(p, NodeType::ABS) { }
 
     Expr const* abs() const override final { return Clone(this); }
-    Expr const* sgn() const override final { return constant(1); }
-    Expr const* acosh() const override final { return f_x->abs(); }
-    Expr const* invert() const override final { return f_x->sech(); }
-    Expr const* xconic() const override final { auto step0 = f_x->sinh(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* sgn() const override final { auto step0 = f_x->sgn(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* cbrt() const override final { auto step0 = f_x->cbrt(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* cos() const override final { return f_x->cos(); }
+    Expr const* sec() const override final { return f_x->sec(); }
+    Expr const* asin() const override final { auto step0 = f_x->asin(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* atan() const override final { auto step0 = f_x->atan(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* sinh() const override final { auto step0 = f_x->sinh(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* cosh() const override final { return f_x->cosh(); }
+    Expr const* tanh() const override final { auto step0 = f_x->tanh(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* sech() const override final { return f_x->sech(); }
+    Expr const* asinh() const override final { auto step0 = f_x->asinh(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* atanh() const override final { auto step0 = f_x->atanh(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* erf() const override final { auto step0 = f_x->erf(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* square() const override final { return f_x->square(); }
+    Expr const* xconic() const override final { return f_x->xconic(); }
+    Expr const* yconic() const override final { return f_x->yconic(); }
+    Expr const* zconic() const override final { return f_x->zconic(); }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->cosh(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->abs(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::cosh(f_x->evaluate()); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::abs(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** TanH
+*** Sgn
 ***********************************************************************************************************************/
 
-struct TanH final : public FunctionNode, private ObjectGuard<TanH>
+struct Sgn final : public FunctionNode, private ObjectGuard<Sgn>
 {
-    TanH(Expr const* p) : FunctionNode(p, NodeType::TANH) { ; }
+    Sgn(Expr const* p) : FunctionNode(p, NodeType::SGN) { }
 
-    Expr const* sgn() const override final { return f_x->sgn(); }
-    Expr const* atanh() const override final { return Clone(f_x); }
+    Expr const* sgn() const override final { return Clone(this); }
+    Expr const* cbrt() const override final { return Clone(this); }
+    Expr const* square() const override final { auto step0 = f_x->square(); auto step1 = step0->sgn(); Erase(step0); return step1; }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->tanh(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sgn(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::tanh(f_x->evaluate()); }
+    Expr const* partial(int) const override final;
+    double value() const override final { auto x = f_x->evaluate(); return double(x > 0) - (x < 0); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** SecH
+*** Sqrt
 ***********************************************************************************************************************/
 
-struct SecH final : public FunctionNode, private ObjectGuard<SecH>
+struct Sqrt final : public FunctionNode, private ObjectGuard<Sqrt>
 {
-    SecH(Expr const* p) : FunctionNode(p, NodeType::SECH) { }
+    Sqrt(Expr const* p) : FunctionNode(p, NodeType::SQRT) { }
 
-    Expr const* invert() const override final { return f_x->cosh(); }
+    Expr const* abs() const override final { return Clone(this); }
+    Expr const* square() const override final { return Clone(f_x); }
+    Expr const* pow(Expr const* p) const override final;
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sech(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sqrt(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return 1 / std::cosh(f_x->evaluate()); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::sqrt(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** ASinH
+*** Cbrt
 ***********************************************************************************************************************/
 
-struct ASinH final : public FunctionNode, private ObjectGuard<ASinH>
+struct Cbrt final : public FunctionNode, private ObjectGuard<Cbrt>
 {
-    ASinH(Expr const* p) : FunctionNode(p, NodeType::ASINH) { }
+    Cbrt(Expr const* p) : FunctionNode(p, NodeType::CBRT) { }
 
     Expr const* sgn() const override final { return f_x->sgn(); }
-    Expr const* exp() const override final { auto step0 = f_x->yconic(); auto step1 = f_x->add(step0); Erase(step0); return step1; }
-    Expr const* sinh() const override final { return Clone(f_x); }
-    Expr const* cosh() const override final { return f_x->yconic(); }
+    Expr const* pow(Expr const*) const override final;
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->asinh(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->cbrt(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::asinh(f_x->evaluate()); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::cbrt(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** ACosH
+*** Exp
 ***********************************************************************************************************************/
 
-struct ACosH final : public FunctionNode, private ObjectGuard<ACosH>
+struct Exp final : public FunctionNode, private ObjectGuard<Exp>
 {
-    ACosH(Expr const* p) : FunctionNode(p, NodeType::ACOSH) { }
+    Exp(Expr const* p) : FunctionNode(p, NodeType::EXP) { }
 
     Expr const* abs() const override final { return Clone(this); }
-    Expr const* sinh() const override final { return f_x->zconic(); }
-    Expr const* cosh() const override final { return Clone(f_x); }
+    Expr const* sgn() const override final { return constant(1); }
+    Expr const* log() const override final { return Clone(f_x); }
+    Expr const* pow(Expr const* p) const override final { auto step0 = f_x->mul(p); auto step1 = step0->exp();  Erase(step0); return step1; }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->acosh(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->exp(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::acosh(f_x->evaluate()); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::exp(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** ATanH
+*** ExpM1
 ***********************************************************************************************************************/
 
-struct ATanH final : public FunctionNode, private ObjectGuard<ATanH>
+struct ExpM1 final : public FunctionNode, private ObjectGuard<ExpM1>
 {
-    ATanH(Expr const* p) : FunctionNode(p, NodeType::ATANH) { }
-
-    Expr const* sgn() const override final { return f_x->sgn(); }
-    Expr const* cosh() const override final { auto step0 = f_x->zconic(); auto step1 = step0->invert(); Erase(step0); return step1; }
-    Expr const* tanh() const override final { return Clone(f_x); }
+    ExpM1(Expr const* p) : FunctionNode(p, NodeType::EXPM1) { }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->atanh(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->expm1(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::atanh(f_x->evaluate()); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::expm1(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** Erf
+*** Log
 ***********************************************************************************************************************/
 
-struct Erf final : public FunctionNode, private ObjectGuard<Erf>
+struct Log final : public FunctionNode, private ObjectGuard<Log>
 {
-    Erf(Expr const* p) : FunctionNode(p, NodeType::ERF) { }
+    Log(Expr const* p) : FunctionNode(p, NodeType::LOG) { }
 
-    Expr const* sgn() const override final { return f_x->sgn(); }
+    Expr const* exp() const override final { return Clone(f_x); }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->erf(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->log(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::erf(f_x->evaluate()); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::log(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** ErfC
+*** Log1P
 ***********************************************************************************************************************/
 
-struct ErfC final : public FunctionNode, private ObjectGuard<ErfC>
+struct Log1P final : public FunctionNode, private ObjectGuard<Log1P>
 {
-    ErfC(Expr const* p) : FunctionNode(p, NodeType::ERF) { }
-
-    // TODO: Expr const* sgn() const override final { return f_x->sgn(); }
+    Log1P(Expr const* p) : FunctionNode(p, NodeType::LOG1P) { }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->erfc(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->log1p(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::erfc(f_x->evaluate()); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::log1p(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** Invert
+*** Sin
 ***********************************************************************************************************************/
 
-struct Invert final : public FunctionNode, private ObjectGuard<Invert>
+struct Sin final : public FunctionNode, private ObjectGuard<Sin>
 {
-    Invert(Expr const* p) : FunctionNode(p, NodeType::INVERT) { }
-
-    Expr const* abs() const override final { auto step0 = f_x->abs(); auto step1 = step0->invert(); Erase(step0); return step1; }
-    Expr const* sgn() const override final { auto step0 = f_x->sgn(); auto step1 = step0->invert(); Erase(step0); return step1; }
-    Expr const* sqrt() const override final { auto step0 = f_x->sqrt(); auto step1 = step0->invert(); Erase(step0); return step1; }
-    Expr const* cbrt() const override final { auto step0 = f_x->cbrt(); auto step1 = step0->invert(); Erase(step0); return step1; }
-    Expr const* log() const override final { auto step0 = f_x->log(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* invert() const override final { return Clone(f_x); }
-    Expr const* square() const override final { auto step0 = f_x->square(); auto step1 = step0->invert(); Erase(step0); return step1; }
-
-    Expr const* mul(Expr const*) const override final;
-    Expr const* pow(Expr const* p) const override final { auto step0 = f_x->pow(p); auto step1 = step0->invert(); Erase(step0); return step1; }
+    Sin(Expr const* p) : FunctionNode(p, NodeType::SIN) { }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->invert(); Erase(step0); return step1; }
+    Expr const* zconic() const override final { auto step0 = f_x->cos(); auto step1 = step0->abs(); Erase(step0); return step1; }
 
-    bool easyInvert() const override final { return true; }
-    bool easyNegate() const override final { return f_x->easyNegate(); }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sin(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return 1 / f_x->evaluate(); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::sin(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** Negate
+*** Cos
 ***********************************************************************************************************************/
 
-struct Negate final : public FunctionNode, private ObjectGuard<Negate>
+struct Cos final : public FunctionNode, private ObjectGuard<Cos>
 {
-    Negate(Expr const* p) : FunctionNode(p, NodeType::NEGATE) { }
-
-    Expr const* abs() const override final { return f_x->abs(); }
-    Expr const* sgn() const override final { auto step0 = f_x->sgn(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* cbrt() const override final { auto step0 = f_x->cbrt(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* exp() const override final { auto step0 = f_x->exp(); auto step1 = step0->invert(); Erase(step0); return step1; }
-    Expr const* sin() const override final { auto step0 = f_x->sin(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* cos() const override final { return f_x->cos(); }
-    Expr const* tan() const override final { auto step0 = f_x->tan(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* sec() const override final { return f_x->sec(); }
-    Expr const* asin() const override final { auto step0 = f_x->asin(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* atan() const override final { auto step0 = f_x->atan(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* sinh() const override final { auto step0 = f_x->sinh(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* cosh() const override final { return f_x->cosh(); }
-    Expr const* tanh() const override final { auto step0 = f_x->tanh(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* sech() const override final { return f_x->sech(); }
-    Expr const* asinh() const override final { auto step0 = f_x->asinh(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* atanh() const override final { auto step0 = f_x->atanh(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* erf() const override final { auto step0 = f_x->erf(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* invert() const override final { auto step0 = f_x->invert(); auto step1 = step0->negate(); Erase(step0); return step1; }
-    Expr const* negate() const override final { return Clone(f_x); }
-    Expr const* square() const override final { return f_x->square(); }
-    Expr const* xconic() const override final { return f_x->xconic(); }
-    Expr const* yconic() const override final { return f_x->yconic(); }
-    Expr const* zconic() const override final { return f_x->zconic(); }
-
-    Expr const* add(Expr const*) const override final;
-    Expr const* mul(Expr const*) const override final;
+    Cos(Expr const* p) : FunctionNode(p, NodeType::COS) { }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* invert() const override final { return f_x->sec(); }
+    Expr const* zconic() const override final { auto step0 = f_x->sin(); auto step1 = step0->abs(); Erase(step0); return step1; }
 
-    bool easyInvert() const override final { return f_x->easyInvert(); }
-    bool easyNegate() const override final { return true; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->cos(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return -f_x->evaluate(); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::cos(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** SoftPP
+*** Tan
 ***********************************************************************************************************************/
 
-struct SoftPP final : public FunctionNode, private ObjectGuard<SoftPP>
+struct Tan final : public FunctionNode, private ObjectGuard<Tan>
 {
-    SoftPP(Expr const* p) : FunctionNode(p, NodeType::SOFTPP) { }
+    Tan(Expr const* p) : FunctionNode(p, NodeType::TAN) { }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->softpp(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->tan(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return Spp(f_x->evaluate()); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::tan(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** Spence
+*** Sec
 ***********************************************************************************************************************/
 
-struct Spence final : public FunctionNode, private ObjectGuard<Spence>
+struct Sec final : public FunctionNode, private ObjectGuard<Sec>
 {
-    Spence(Expr const* p) : FunctionNode(p, NodeType::SPENCE) { }
+    Sec(Expr const* p) : FunctionNode(p, NodeType::SEC) { }
+
+    Expr const* invert() const override final { return f_x->cos(); }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->spence(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sec(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return Li2(f_x->evaluate()); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return 1 / std::cos(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** Square
+*** ASin
 ***********************************************************************************************************************/
 
-struct Square final : public FunctionNode, private ObjectGuard<Square>
+struct ASin final : public FunctionNode, private ObjectGuard<ASin>
 {
-    Square(Expr const* p) : FunctionNode(p, NodeType::SQUARE) { }
-
-    Expr const* abs() const override final { return Clone(this); }
-    Expr const* sqrt() const override final { return f_x->abs(); }
+    ASin(Expr const* p) : FunctionNode(p, NodeType::ASIN) { }
 
-    Expr const* pow(Expr const* p) const override final;
+    Expr const* sgn() const override final { return f_x->sgn(); }
+    Expr const* sin() const override final { return Clone(f_x); }
+    Expr const* cos() const override final { return f_x->zconic(); }
+    Expr const* sec() const override final { auto step0 = f_x->zconic(); auto step1 = step0->invert(); Erase(step0); return step1; }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->square(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->asin(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { auto x = f_x->evaluate(); return x * x; }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::asin(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** XConic
+*** ACos
 ***********************************************************************************************************************/
 
-struct XConic final : public FunctionNode, private ObjectGuard<XConic>
+struct ACos final : public FunctionNode, private ObjectGuard<ACos>
 {
-    XConic(Expr const* p) : FunctionNode(p, NodeType::XCONIC) { }
+    ACos(Expr const* p) : FunctionNode(p, NodeType::ACOS) { }
 
     Expr const* abs() const override final { return Clone(this); }
-    Expr const* asinh() const override final { auto step0 = f_x->abs(); auto step1 = step0->acosh(); Erase(step0); return step1; }
-    Expr const* yconic() const override final { return f_x->abs(); }
+    Expr const* sin() const override final { return f_x->zconic(); }
+    Expr const* cos() const override final { return Clone(f_x); }
+    Expr const* sec() const override final { return f_x->invert(); }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->xconic(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->acos(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { auto x = f_x->evaluate(); return std::sqrt(x * x - 1); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::acos(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** YConic
+*** ATan
 ***********************************************************************************************************************/
 
-struct YConic final : public FunctionNode, private ObjectGuard<YConic>
+struct ATan final : public FunctionNode, private ObjectGuard<ATan>
 {
-    YConic(Expr const* p) : FunctionNode(p, NodeType::YCONIC) { }
+    ATan(Expr const* p) : FunctionNode(p, NodeType::ATAN) { }
 
-    Expr const* abs() const override final { return Clone(this); }
-    Expr const* acosh() const override final { auto step0 = f_x->asinh(); auto step1 = step0->abs(); Erase(step0); return step1; }
-    Expr const* xconic() const override final { return f_x->abs(); }
+    Expr const* sgn() const override final { return f_x->sgn(); }
+    Expr const* cos() const override final { auto step0 = f_x->yconic(); auto step1 = step0->invert(); Erase(step0); return step1; }
+    Expr const* tan() const override final { return Clone(f_x); }
+    Expr const* sec() const override final { return f_x->yconic(); }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->yconic(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->atan(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { auto x = f_x->evaluate(); return std::sqrt(x * x + 1); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::atan(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** ZConic
+*** SinH
 ***********************************************************************************************************************/
 
-struct ZConic final : public FunctionNode, private ObjectGuard<ZConic>
+struct SinH final : public FunctionNode, private ObjectGuard<SinH>
 {
-    ZConic(Expr const* p) : FunctionNode(p, NodeType::ZCONIC) { }
+    SinH(Expr const* p) : FunctionNode(p, NodeType::SINH) { }
 
-    Expr const* abs() const override final { return Clone(this); }
-    Expr const* asin() const override final { auto step0 = f_x->abs(); auto step1 = step0->acos(); Erase(step0); return step1; }
-    Expr const* acos() const override final { auto step0 = f_x->asin(); auto step1 = step0->abs(); Erase(step0); return step1; }
-    Expr const* zconic() const override final { return f_x->abs(); }
+    Expr const* sgn() const override final { return f_x->sgn(); }
+    Expr const* asinh() const override final { return Clone(f_x); }
+    Expr const* yconic() const override final { return f_x->cosh(); }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->zconic(); Erase(step0); return step1; }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sinh(); Erase(step0); return step1; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { auto x = f_x->evaluate(); return std::sqrt(1 - x * x); }
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::sinh(f_x->evaluate()); }
 
-    void print(std::ostream&) const override final;
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** function()
+*** CosH
 ***********************************************************************************************************************/
 
-Expr const* Expression::data::function(NodeType n) const
+struct CosH final : public FunctionNode, private ObjectGuard<CosH>
 {
-    auto node = functionNode.find(n);
-    if (node != functionNode.end()) { return Clone(node->second); }
+    CosH(Expr const* p) : FunctionNode(p, NodeType::COSH) { }
 
-    switch (n)
-    {
-    case NodeType::ABS:
-        return new Abs(Clone(this));
+    Expr const* abs() const override final { return Clone(this); }
+    Expr const* sgn() const override final { return constant(1); }
+    Expr const* acosh() const override final { return f_x->abs(); }
+    Expr const* invert() const override final { return f_x->sech(); }
+    Expr const* xconic() const override final { auto step0 = f_x->sinh(); auto step1 = step0->abs(); Erase(step0); return step1; }
 
-    case NodeType::SGN:
-        return new Sgn(Clone(this));
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->cosh(); Erase(step0); return step1; }
 
-    case NodeType::SQRT:
-        return new Sqrt(Clone(this));
+    bool attribute(Attr) const override final;
 
-    case NodeType::CBRT:
-        return new Cbrt(Clone(this));
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::cosh(f_x->evaluate()); }
 
-    case NodeType::EXP:
-        return new Exp(Clone(this));
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
-    case NodeType::EXPM1:
-        return new ExpM1(Clone(this));
+/***********************************************************************************************************************
+*** TanH
+***********************************************************************************************************************/
 
-    case NodeType::LOG:
-        return new Log(Clone(this));
+struct TanH final : public FunctionNode, private ObjectGuard<TanH>
+{
+    TanH(Expr const* p) : FunctionNode(p, NodeType::TANH) { ; }
 
-    case NodeType::LOG1P:
-        return new Log1P(Clone(this));
+    Expr const* sgn() const override final { return f_x->sgn(); }
+    Expr const* atanh() const override final { return Clone(f_x); }
 
-    case NodeType::SIN:
-        return new Sin(Clone(this));
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->tanh(); Erase(step0); return step1; }
 
-    case NodeType::COS:
-        return new Cos(Clone(this));
+    bool attribute(Attr) const override final;
 
-    case NodeType::TAN:
-        return new Tan(Clone(this));
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::tanh(f_x->evaluate()); }
 
-    case NodeType::SEC:
-        return new Sec(Clone(this));
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
-    case NodeType::ASIN:
-        return new ASin(Clone(this));
+/***********************************************************************************************************************
+*** SecH
+***********************************************************************************************************************/
 
-    case NodeType::ACOS:
-        return new ACos(Clone(this));
+struct SecH final : public FunctionNode, private ObjectGuard<SecH>
+{
+    SecH(Expr const* p) : FunctionNode(p, NodeType::SECH) { }
 
-    case NodeType::ATAN:
-        return new ATan(Clone(this));
+    Expr const* invert() const override final { return f_x->cosh(); }
 
-    case NodeType::SINH:
-        return new SinH(Clone(this));
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->sech(); Erase(step0); return step1; }
 
-    case NodeType::COSH:
-        return new CosH(Clone(this));
+    bool attribute(Attr) const override final;
 
-    case NodeType::TANH:
-        return new TanH(Clone(this));
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return 1 / std::cosh(f_x->evaluate()); }
 
-    case NodeType::SECH:
-        return new SecH(Clone(this));
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
-    case NodeType::ASINH:
-        return new ASinH(Clone(this));
+/***********************************************************************************************************************
+*** ASinH
+***********************************************************************************************************************/
 
-    case NodeType::ACOSH:
-        return new ACosH(Clone(this));
+struct ASinH final : public FunctionNode, private ObjectGuard<ASinH>
+{
+    ASinH(Expr const* p) : FunctionNode(p, NodeType::ASINH) { }
 
-    case NodeType::ATANH:
-        return new ATanH(Clone(this));
+    Expr const* sgn() const override final { return f_x->sgn(); }
+    Expr const* exp() const override final { auto step0 = f_x->yconic(); auto step1 = f_x->add(step0); Erase(step0); return step1; }
+    Expr const* sinh() const override final { return Clone(f_x); }
+    Expr const* cosh() const override final { return f_x->yconic(); }
 
-    case NodeType::ERF:
-        return new Erf(Clone(this));
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->asinh(); Erase(step0); return step1; }
 
-    case NodeType::ERFC:
-        return new ErfC(Clone(this));
+    bool attribute(Attr) const override final;
 
-    case NodeType::INVERT:
-        return new Invert(Clone(this));
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::asinh(f_x->evaluate()); }
 
-    case NodeType::NEGATE:
-        return new Negate(Clone(this));
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
-    case NodeType::SOFTPP:
-        return new SoftPP(Clone(this));
+/***********************************************************************************************************************
+*** ACosH
+***********************************************************************************************************************/
 
-    case NodeType::SPENCE:
-        return new Spence(Clone(this));
+struct ACosH final : public FunctionNode, private ObjectGuard<ACosH>
+{
+    ACosH(Expr const* p) : FunctionNode(p, NodeType::ACOSH) { }
 
-    case NodeType::SQUARE:
-        return new Square(Clone(this));
+    Expr const* abs() const override final { return Clone(this); }
+    Expr const* sinh() const override final { return f_x->zconic(); }
+    Expr const* cosh() const override final { return Clone(f_x); }
 
-    case NodeType::XCONIC:
-        return new XConic(Clone(this));
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->acosh(); Erase(step0); return step1; }
 
-    case NodeType::YCONIC:
-        return new YConic(Clone(this));
+    bool attribute(Attr) const override final;
 
-    case NodeType::ZCONIC:
-        return new ZConic(Clone(this));
-    }
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::acosh(f_x->evaluate()); }
 
-    return Clone(Nan::instance);
-}
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
 /***********************************************************************************************************************
-*** Add
+*** ATanH
 ***********************************************************************************************************************/
 
-struct Add final : public OperatorNode, private ObjectGuard<Add>
+struct ATanH final : public FunctionNode, private ObjectGuard<ATanH>
 {
-    Add(Expr const* p, Expr const* q) : OperatorNode(p, q)
-    {
-        assert(f_x->addNode.find(g_x) == f_x->addNode.end());
-        assert(g_x->addNode.find(f_x) == g_x->addNode.end());
+    ATanH(Expr const* p) : FunctionNode(p, NodeType::ATANH) { }
 
-        f_x->addNode[g_x] = this;
-        g_x->addNode[f_x] = this;
-    }
+    Expr const* sgn() const override final { return f_x->sgn(); }
+    Expr const* cosh() const override final { auto step0 = f_x->zconic(); auto step1 = step0->invert(); Erase(step0); return step1; }
+    Expr const* tanh() const override final { return Clone(f_x); }
 
-    double value() const override final { return f_x->evaluate() + g_x->evaluate(); }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->atanh(); Erase(step0); return step1; }
 
-    Expr const* add(Expr const*) const override final;
-    Expr const* commutative_add(Expr const*) const override final;
-    Expr const* mul(Expr const*) const override final;
-    Expr const* commutative_mul(Expr const*) const override final;
+    bool attribute(Attr) const override final;
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final
-    {
-        auto step0 = f_x->bind(r);
-        auto step1 = g_x->bind(r);
-        auto step2 = step0->add(step1);
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::atanh(f_x->evaluate()); }
 
-        Erase(step0);
-        Erase(step1);
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
-        return step2;
-    }
+/***********************************************************************************************************************
+*** Erf
+***********************************************************************************************************************/
 
-    bool is(NodeType t) const override final { return t == NodeType::ADD; }
+struct Erf final : public FunctionNode, private ObjectGuard<Erf>
+{
+    Erf(Expr const* p) : FunctionNode(p, NodeType::ERF) { }
 
-    bool guaranteed(Attr) const override final;
+    Expr const* sgn() const override final { return f_x->sgn(); }
 
-    Expr const* derivative(Variable const&) const override final;
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->erf(); Erase(step0); return step1; }
 
-    void print(std::ostream&) const override final;
+    bool attribute(Attr) const override final;
 
-private:
-    virtual ~Add()
-    {
-        assert(f_x->addNode.find(g_x) != f_x->addNode.end() && f_x->addNode[g_x] == this);
-        assert(g_x->addNode.find(f_x) != g_x->addNode.end() && g_x->addNode[f_x] == this);
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::erf(f_x->evaluate()); }
 
-        f_x->addNode.erase(g_x);
-        g_x->addNode.erase(f_x);
-    }
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** Mul
+*** ErfC
 ***********************************************************************************************************************/
 
-struct Mul final : public OperatorNode, private ObjectGuard<Mul>
+struct ErfC final : public FunctionNode, private ObjectGuard<ErfC>
 {
-    Mul(Expr const* p, Expr const* q) : OperatorNode(p, q)
-    {
-        assert(f_x->mulNode.find(g_x) == f_x->mulNode.end());
-        assert(g_x->mulNode.find(f_x) == g_x->mulNode.end());
+    ErfC(Expr const* p) : FunctionNode(p, NodeType::ERFC) { }
 
-        f_x->mulNode[g_x] = this;
-        g_x->mulNode[f_x] = this;
-    }
+    // TODO: Expr const* sgn() const override final { return f_x->sgn(); }
 
-    Expr const* mul(Expr const*) const override final;
-    Expr const* commutative_mul(Expr const*) const override final;
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->erfc(); Erase(step0); return step1; }
 
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final
-    {
-        auto step0 = f_x->bind(r);
-        auto step1 = g_x->bind(r);
-        auto step2 = step0->mul(step1);
+    bool attribute(Attr) const override final;
 
-        Erase(step0);
-        Erase(step1);
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::erfc(f_x->evaluate()); }
 
-        return step2;
-    }
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
-    bool is(NodeType t) const override final { return t == NodeType::MUL; }
+/***********************************************************************************************************************
+*** Invert
+***********************************************************************************************************************/
 
-    bool guaranteed(Attr) const override final;
+struct Invert final : public FunctionNode, private ObjectGuard<Invert>
+{
+    Invert(Expr const* p) : FunctionNode(p, NodeType::INVERT) { }
 
-    Expr const* derivative(Variable const&) const override final;
-    double value() const override final;
+    Expr const* abs() const override final { auto step0 = f_x->abs(); auto step1 = step0->invert(); Erase(step0); return step1; }
+    Expr const* sgn() const override final { auto step0 = f_x->sgn(); auto step1 = step0->invert(); Erase(step0); return step1; }
+    Expr const* sqrt() const override final { auto step0 = f_x->sqrt(); auto step1 = step0->invert(); Erase(step0); return step1; }
+    Expr const* cbrt() const override final { auto step0 = f_x->cbrt(); auto step1 = step0->invert(); Erase(step0); return step1; }
+    Expr const* log() const override final { auto step0 = f_x->log(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* invert() const override final { return Clone(f_x); }
+    Expr const* square() const override final { auto step0 = f_x->square(); auto step1 = step0->invert(); Erase(step0); return step1; }
 
-    void print(std::ostream&) const override final;
+    Expr const* mul(Expr const*) const override final;
+    Expr const* pow(Expr const* p) const override final { auto step0 = f_x->pow(p); auto step1 = step0->invert(); Erase(step0); return step1; }
 
-private:
-    virtual ~Mul()
-    {
-        assert(f_x->mulNode.find(g_x) != f_x->mulNode.end() && f_x->mulNode[g_x] == this);
-        assert(g_x->mulNode.find(f_x) != g_x->mulNode.end() && g_x->mulNode[f_x] == this);
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->invert(); Erase(step0); return step1; }
 
-        f_x->mulNode.erase(g_x);
-        g_x->mulNode.erase(f_x);
-    }
+    bool easyInvert() const override final { return true; }
+    bool easyNegate() const override final { return f_x->easyNegate(); }
+
+    bool attribute(Attr) const override final;
+
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return 1 / f_x->evaluate(); }
+
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** Pow
+*** Negate
 ***********************************************************************************************************************/
 
-struct Pow final : public OperatorNode, private ObjectGuard<Pow>
+struct Negate final : public FunctionNode, private ObjectGuard<Negate>
 {
-    Pow(Expr const* p, Expr const* q) : OperatorNode(p, q)
-    {
-        assert(f_x->powNode.find(g_x) == f_x->powNode.end());
-
-        f_x->powNode[g_x] = this;
-    }
+    Negate(Expr const* p) : FunctionNode(p, NodeType::NEGATE) { }
 
-    Expr const* sqrt() const override final;
-    Expr const* cbrt() const override final;
-    Expr const* invert() const override final { auto step0 = g_x->negate(); auto step1 = f_x->pow(step0); Erase(step0); return step1; }
-    Expr const* square() const override final;
+    Expr const* abs() const override final { return f_x->abs(); }
+    Expr const* sgn() const override final { auto step0 = f_x->sgn(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* cbrt() const override final { auto step0 = f_x->cbrt(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* exp() const override final { auto step0 = f_x->exp(); auto step1 = step0->invert(); Erase(step0); return step1; }
+    Expr const* sin() const override final { auto step0 = f_x->sin(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* cos() const override final { return f_x->cos(); }
+    Expr const* tan() const override final { auto step0 = f_x->tan(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* sec() const override final { return f_x->sec(); }
+    Expr const* asin() const override final { auto step0 = f_x->asin(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* atan() const override final { auto step0 = f_x->atan(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* sinh() const override final { auto step0 = f_x->sinh(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* cosh() const override final { return f_x->cosh(); }
+    Expr const* tanh() const override final { auto step0 = f_x->tanh(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* sech() const override final { return f_x->sech(); }
+    Expr const* asinh() const override final { auto step0 = f_x->asinh(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* atanh() const override final { auto step0 = f_x->atanh(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* erf() const override final { auto step0 = f_x->erf(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* invert() const override final { auto step0 = f_x->invert(); auto step1 = step0->negate(); Erase(step0); return step1; }
+    Expr const* negate() const override final { return Clone(f_x); }
+    Expr const* square() const override final { return f_x->square(); }
+    Expr const* xconic() const override final { return f_x->xconic(); }
+    Expr const* yconic() const override final { return f_x->yconic(); }
+    Expr const* zconic() const override final { return f_x->zconic(); }
 
+    Expr const* add(Expr const*) const override final;
     Expr const* mul(Expr const*) const override final;
-    Expr const* commutative_mul(Expr const*) const override final;
-    Expr const* pow(Expr const* p) const override final { auto step0 = g_x->mul(p); auto step1 = f_x->pow(step0); Erase(step0); return step1; }
-
-    Expr const* bind(std::vector<std::pair<Variable, Expr const*>> const& r) const override final
-    {
-        auto step0 = f_x->bind(r);
-        auto step1 = g_x->bind(r);
-        auto step2 = step0->pow(step1);
-
-        Erase(step0);
-        Erase(step1);
 
-        return step2;
-    }
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->negate(); Erase(step0); return step1; }
 
-    bool is(NodeType t) const override final { return t == NodeType::POW; }
+    bool easyInvert() const override final { return f_x->easyInvert(); }
+    bool easyNegate() const override final { return true; }
 
-    bool guaranteed(Attr) const override final;
+    bool attribute(Attr) const override final;
 
     Expr const* derivative(Variable const&) const override final;
-    double value() const override final { return std::pow(f_x->evaluate(), g_x->evaluate()); }
-
-    void print(std::ostream&) const override final;
-
-private:
-    virtual ~Pow()
-    {
-        assert(f_x->powNode.find(g_x) != f_x->powNode.end() && f_x->powNode[g_x] == this);
+    Expr const* partial(int) const override final;
+    double value() const override final { return -f_x->evaluate(); }
 
-        f_x->powNode.erase(g_x);
-    }
+    void print(std::ostream&, std::vector<Token>&) const override final;
 };
 
 /***********************************************************************************************************************
-*** abs()
+*** SoftPP
 ***********************************************************************************************************************/
 
-Expr const* Expression::data::abs() const
+struct SoftPP final : public FunctionNode, private ObjectGuard<SoftPP>
 {
-    if (guaranteed(Attr::NONNEGATIVE)) return Clone(this);
-    if (guaranteed(Attr::NONPOSITIVE)) return negate();
-    return function(NodeType::ABS);
-}
+    SoftPP(Expr const* p) : FunctionNode(p, NodeType::SOFTPP) { }
+
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->softpp(); Erase(step0); return step1; }
+
+    bool attribute(Attr) const override final;
+
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return Spp(f_x->evaluate()); }
+
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
 /***********************************************************************************************************************
-*** sgn()
+*** Spence
 ***********************************************************************************************************************/
 
-Expr const* Expression::data::sgn() const
+struct Spence final : public FunctionNode, private ObjectGuard<Spence>
 {
-    if (guaranteed(Attr::POSITIVE)) return constant(1);
-    if (guaranteed(Attr::NEGATIVE)) return constant(-1);
-    return function(NodeType::SGN);
-}
-
-/***********************************************************************************************************************
-*** sqrt()
-***********************************************************************************************************************/
+    Spence(Expr const* p) : FunctionNode(p, NodeType::SPENCE) { }
 
-Expr const* Pow::sqrt() const
-{
-    static ConstantNode inv2(1.0 / 2);
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->spence(); Erase(step0); return step1; }
 
-    auto step0 = g_x->mul(inv2);
-    auto step1 = f_x->pow(step0);
+    bool attribute(Attr) const override final;
 
-    Erase(step0);
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return Li2(f_x->evaluate()); }
 
-    return step1;
-}
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
 /***********************************************************************************************************************
-*** cbrt()
+*** Square
 ***********************************************************************************************************************/
 
-Expr const* Pow::cbrt() const
+struct Square final : public FunctionNode, private ObjectGuard<Square>
 {
-    static ConstantNode inv3(1.0 / 3);
-
-    auto step0 = g_x->mul(inv3);
-    auto step1 = f_x->pow(step0);
-
-    Erase(step0);
+    Square(Expr const* p) : FunctionNode(p, NodeType::SQUARE) { }
 
-    return step1;
-}
+    Expr const* abs() const override final { return Clone(this); }
+    Expr const* sqrt() const override final { return f_x->abs(); }
 
-/***********************************************************************************************************************
-*** square()
-***********************************************************************************************************************/
+    Expr const* pow(Expr const* p) const override final;
 
-Expr const* Pow::square() const
-{
-    static ConstantNode num2(2);
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->square(); Erase(step0); return step1; }
 
-    auto step0 = g_x->mul(num2);
-    auto step1 = f_x->pow(step0);
+    bool attribute(Attr) const override final;
 
-    Erase(step0);
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { auto x = f_x->evaluate(); return x * x; }
 
-    return step1;
-}
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
 /***********************************************************************************************************************
-*** add()
+*** XConic
 ***********************************************************************************************************************/
 
-Expr const* Expression::data::add(Expr const* p) const
+struct XConic final : public FunctionNode, private ObjectGuard<XConic>
 {
-    return p->commutative_add(this);
-}
+    XConic(Expr const* p) : FunctionNode(p, NodeType::XCONIC) { }
 
-Expr const* Expression::data::commutative_add(Expr const* p) const
-{
-    auto node = addNode.find(p);
-    return node != addNode.end() ? Clone(node->second) : new Add(Clone(p), Clone(this));
-}
+    Expr const* abs() const override final { return Clone(this); }
+    Expr const* asinh() const override final { auto step0 = f_x->abs(); auto step1 = step0->acosh(); Erase(step0); return step1; }
+    Expr const* yconic() const override final { return f_x->abs(); }
 
-Expr const* ConstantNode::add(Expr const* p) const
-{
-    if (p->is(NodeType::CONSTANT)) return constant(n + p->evaluate());
-    if (n == 0) return Clone(p);
-    return Expr::add(p);
-}
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->xconic(); Erase(step0); return step1; }
 
-Expr const* ConstantNode::commutative_add(Expr const* p) const
-{
-    if (p->is(NodeType::CONSTANT)) return constant(n + p->evaluate());
-    if (n == 0) return Clone(p);
-    return Expr::commutative_add(p);
-}
+    bool attribute(Attr) const override final;
 
-Expr const* Negate::add(Expr const* p) const
-{
-    return Expr::add(p);
-}
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { auto x = f_x->evaluate(); return std::sqrt(x * x - 1); }
+
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
+
+/***********************************************************************************************************************
+*** YConic
+***********************************************************************************************************************/
 
-Expr const* Add::add(Expr const* p) const
+struct YConic final : public FunctionNode, private ObjectGuard<YConic>
 {
-    if (depth > STACK_LIMIT)
-    {
-        if (f_x->depth < g_x->depth)
-        {
-            auto step0 = f_x->add(p);
-            auto step1 = g_x->add(step0);
-            Erase(step0);
-            return step1;
-        }
+    YConic(Expr const* p) : FunctionNode(p, NodeType::YCONIC) { }
 
-        if (f_x->depth > g_x->depth)
-        {
-            auto step0 = g_x->add(p);
-            auto step1 = f_x->add(step0);
-            Erase(step0);
-            return step1;
-        }
-    }
+    Expr const* abs() const override final { return Clone(this); }
+    Expr const* acosh() const override final { auto step0 = f_x->asinh(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* xconic() const override final { return f_x->abs(); }
 
-    return Expr::add(p);
-}
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->yconic(); Erase(step0); return step1; }
 
-Expr const* Add::commutative_add(Expr const* p) const
-{
-    if (depth > STACK_LIMIT)
-    {
-        if (f_x->depth < g_x->depth)
-        {
-            auto step0 = f_x->commutative_add(p);
-            auto step1 = g_x->commutative_add(step0);
-            Erase(step0);
-            return step1;
-        }
+    bool attribute(Attr) const override final;
 
-        if (f_x->depth > g_x->depth)
-        {
-            auto step0 = g_x->commutative_add(p);
-            auto step1 = f_x->commutative_add(step0);
-            Erase(step0);
-            return step1;
-        }
-    }
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { auto x = f_x->evaluate(); return std::sqrt(x * x + 1); }
 
-    return Expr::commutative_add(p);
-}
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
 /***********************************************************************************************************************
-*** mul()
+*** ZConic
 ***********************************************************************************************************************/
 
-Expr const* Expression::data::mul(Expr const* p) const
+struct ZConic final : public FunctionNode, private ObjectGuard<ZConic>
 {
-    if (p == this) return square();
-    return p->commutative_mul(this);
-}
+    ZConic(Expr const* p) : FunctionNode(p, NodeType::ZCONIC) { }
 
-Expr const* Expression::data::commutative_mul(Expr const* p) const
-{
-    auto node = mulNode.find(p);
-    return node != mulNode.end() ? Clone(node->second) : new Mul(Clone(p), Clone(this));
-}
+    Expr const* abs() const override final { return Clone(this); }
+    Expr const* asin() const override final { auto step0 = f_x->abs(); auto step1 = step0->acos(); Erase(step0); return step1; }
+    Expr const* acos() const override final { auto step0 = f_x->asin(); auto step1 = step0->abs(); Erase(step0); return step1; }
+    Expr const* zconic() const override final { return f_x->abs(); }
 
-Expr const* ConstantNode::mul(Expr const* p) const
-{
-    if (p->is(NodeType::CONSTANT)) return constant(n * p->evaluate());
-    if (n == 0) return Clone(this);
-    if (n == 1) return Clone(p);
-    if (n == -1) return p->negate();
-    return Expr::mul(p);
-}
+    Expr const* binding(Substitution const& r) const override final { auto step0 = f_x->bind(r); auto step1 = step0->zconic(); Erase(step0); return step1; }
 
-Expr const* ConstantNode::commutative_mul(Expr const* p) const
-{
-    if (p->is(NodeType::CONSTANT)) return constant(n * p->evaluate());
-    if (n == 0) return Clone(this);
-    if (n == 1) return Clone(p);
-    if (n == -1) return p->negate();
-    return Expr::commutative_mul(p);
-}
+    bool attribute(Attr) const override final;
 
-Expr const* Invert::mul(Expr const* p) const
-{
-    if (p->easyInvert())  // 1/x * 1/p  ---->  1/(x * p)
-    {
-        auto step0 = p->invert();
-        auto step1 = f_x->mul(step0);
-        auto step2 = step1->invert();
-        Erase(step0);
-        Erase(step1);
-        return step2;
-    }
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { auto x = f_x->evaluate(); return std::sqrt(1 - x * x); }
 
-    return Expr::mul(p);
-}
+    void print(std::ostream&, std::vector<Token>&) const override final;
+};
 
-Expr const* Negate::mul(Expr const* p) const
-{
-    if (p->easyNegate())  // -x * -p  ---->  x * p
-    {
-        auto step0 = p->negate();
-        auto step1 = f_x->mul(step0);
-        Erase(step0);
-        return step1;
-    }
-    else  // -x * p  ---->  -(x * p)
-    {
-        auto step0 = f_x->mul(p);
-        auto step1 = step0->negate();
-        Erase(step0);
-        return step1;
-    }
-}
+/***********************************************************************************************************************
+*** function()
+***********************************************************************************************************************/
 
-Expr const* Add::mul(Expr const* p) const
+Expr const* Expression::data::function(NodeType n) const
 {
-    if (depth > STACK_LIMIT)
+    Claim claim(stripe(n, this), [&] { return lookup(n, this); });
+    if (claim.node) return claim.node;
+
+    switch (n)
     {
-        auto step0 = f_x->mul(p);
-        auto step1 = g_x->mul(p);
-        auto step2 = step0->add(step1);
-        Erase(step0);
-        Erase(step1);
-        return step2;
-    }
+    case NodeType::ABS:
+        return new Abs(Clone(this));
 
-    return Expr::mul(p);
-}
+    case NodeType::SGN:
+        return new Sgn(Clone(this));
 
-Expr const* Add::commutative_mul(Expr const* p) const
-{
-    if (depth > STACK_LIMIT)
-    {
-        auto step0 = p->commutative_mul(f_x);
-        auto step1 = p->commutative_mul(g_x);
-        auto step2 = step0->add(step1);
-        Erase(step0);
-        Erase(step1);
-        return step2;
-    }
+    case NodeType::SQRT:
+        return new Sqrt(Clone(this));
 
-    return Expr::commutative_mul(p);
-}
+    case NodeType::CBRT:
+        return new Cbrt(Clone(this));
 
-Expr const* Mul::mul(Expr const* p) const
-{
-    if (depth > STACK_LIMIT)
-    {
-        if (f_x->depth < g_x->depth)
-        {
-            auto step0 = f_x->mul(p);
-            auto step1 = g_x->mul(step0);
-            Erase(step0);
-            return step1;
-        }
+    case NodeType::EXP:
+        return new Exp(Clone(this));
 
-        if (f_x->depth > g_x->depth)
-        {
-            auto step0 = g_x->mul(p);
-            auto step1 = f_x->mul(step0);
-            Erase(step0);
-            return step1;
-        }
-    }
+    case NodeType::EXPM1:
+        return new ExpM1(Clone(this));
 
-    return Expr::mul(p);
-}
+    case NodeType::LOG:
+        return new Log(Clone(this));
 
-Expr const* Mul::commutative_mul(Expr const* p) const
-{
-    if (depth > STACK_LIMIT)
-    {
-        if (f_x->depth < g_x->depth)
-        {
-            auto step0 = f_x->commutative_mul(p);
-            auto step1 = g_x->commutative_mul(step0);
-            Erase(step0);
-            return step1;
-        }
+    case NodeType::LOG1P:
+        return new Log1P(Clone(this));
 
-        if (f_x->depth > g_x->depth)
-        {
-            auto step0 = g_x->commutative_mul(p);
-            auto step1 = f_x->commutative_mul(step0);
-            Erase(step0);
-            return step1;
-        }
-    }
+    case NodeType::SIN:
+        return new Sin(Clone(this));
 
-    return Expr::commutative_mul(p);
-}
+    case NodeType::COS:
+        return new Cos(Clone(this));
 
-Expr const* Pow::mul(Expr const* p) const
-{
-    static ConstantNode num1(1);
+    case NodeType::TAN:
+        return new Tan(Clone(this));
 
-    if (f_x == p)
-    {
-        auto step0 = g_x->add(num1);
-        auto step1 = f_x->pow(step0);
+    case NodeType::SEC:
+        return new Sec(Clone(this));
 
-        Erase(step0);
+    case NodeType::ASIN:
+        return new ASin(Clone(this));
 
-        return step1;
-    }
+    case NodeType::ACOS:
+        return new ACos(Clone(this));
 
-    return Expr::mul(p);
-}
+    case NodeType::ATAN:
+        return new ATan(Clone(this));
 
-Expr const* Pow::commutative_mul(Expr const* p) const
-{
-    static ConstantNode num1(1);
+    case NodeType::SINH:
+        return new SinH(Clone(this));
 
-    if (f_x == p)
+    case NodeType::COSH:
+        return new CosH(Clone(this));
+
+    case NodeType::TANH:
+        return new TanH(Clone(this));
+
+    case NodeType::SECH:
+        return new SecH(Clone(this));
+
+    case NodeType::ASINH:
+        return new ASinH(Clone(this));
+
+    case NodeType::ACOSH:
+        return new ACosH(Clone(this));
+
+    case NodeType::ATANH:
+        return new ATanH(Clone(this));
+
+    case NodeType::ERF:
+        return new Erf(Clone(this));
+
+    case NodeType::ERFC:
+        return new ErfC(Clone(this));
+
+    case NodeType::INVERT:
+        return new Invert(Clone(this));
+
+    case NodeType::NEGATE:
+        return new Negate(Clone(this));
+
+    case NodeType::SOFTPP:
+        return new SoftPP(Clone(this));
+
+    case NodeType::SPENCE:
+        return new Spence(Clone(this));
+
+    case NodeType::SQUARE:
+        return new Square(Clone(this));
+
+    case NodeType::XCONIC:
+        return new XConic(Clone(this));
+
+    case NodeType::YCONIC:
+        return new YConic(Clone(this));
+
+    case NodeType::ZCONIC:
+        return new ZConic(Clone(this));
+    }
+
+    return Clone(Nan::instance);
+}
+
+/***********************************************************************************************************************
+*** Add
+***********************************************************************************************************************/
+
+struct Add final : public ListNode, private ObjectGuard<Add>
+{
+    explicit Add(Terms const& r) : ListNode(r)
     {
-        auto step0 = g_x->add(num1);
-        auto step1 = f_x->pow(step0);
+        enter(this, NodeType::ADD, terms);
+    }
 
-        Erase(step0);
+    double value() const override final
+    {
+        double x = 0;
+        for (auto p : terms) x += p->evaluate();
+        return x;
+    }
+
+    Expr const* binding(Substitution const& r) const override final
+    {
+        Terms step0;
+        for (auto p : terms) step0.push_back(p->bind(r));
+        auto step1 = sum(step0);
+
+        for (auto p : step0) Erase(p);
 
         return step1;
     }
 
-    return Expr::commutative_mul(p);
-}
+    bool is(NodeType t) const override final { return t == NodeType::ADD; }
+    NodeType type() const override final { return NodeType::ADD; }
+
+    bool attribute(Attr) const override final;
+    Interval interval() const override final;
+
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+
+    void print(std::ostream&, std::vector<Token>&) const override final;
+
+private:
+    virtual ~Add()
+    {
+        assert(lookup(NodeType::ADD, terms) == this);
+        leave(this, NodeType::ADD, terms);
+    }
+};
 
 /***********************************************************************************************************************
-*** pow()
+*** Mul
 ***********************************************************************************************************************/
 
-Expr const* Expression::data::pow(Expr const* p) const
+struct Mul final : public ListNode, private ObjectGuard<Mul>
 {
-    if (p->is(NodeType::CONSTANT))
+    explicit Mul(Terms const& r) : ListNode(r)
     {
-        double n = p->evaluate();
-        if (n == 0) return constant(1);
-        if (n == 1) return Clone(this);
-        if (n == 2) return square();
-        if (n == -1) return invert();
-        if (n == 1.0 / 2.0) return sqrt();
-        if (n == 1.0 / 3.0) return cbrt();
+        enter(this, NodeType::MUL, terms);
+    }
+
+    Expr const* binding(Substitution const& r) const override final
+    {
+        Terms step0;
+        for (auto p : terms) step0.push_back(p->bind(r));
+        auto step1 = product(step0);
+
+        for (auto p : step0) Erase(p);
+
+        return step1;
+    }
+
+    bool is(NodeType t) const override final { return t == NodeType::MUL; }
+    NodeType type() const override final { return NodeType::MUL; }
+
+    bool attribute(Attr) const override final;
+    Interval interval() const override final;
+
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final;
+
+    void print(std::ostream&, std::vector<Token>&) const override final;
+
+private:
+    virtual ~Mul()
+    {
+        assert(lookup(NodeType::MUL, terms) == this);
+        leave(this, NodeType::MUL, terms);
+    }
+};
+
+/***********************************************************************************************************************
+*** Pow
+***********************************************************************************************************************/
+
+struct Pow final : public OperatorNode, private ObjectGuard<Pow>
+{
+    Pow(Expr const* p, Expr const* q) : OperatorNode(p, q)
+    {
+        enter(this, NodeType::POW, f_x, g_x);
+    }
+
+    Expr const* sqrt() const override final;
+    Expr const* cbrt() const override final;
+    Expr const* invert() const override final { auto step0 = g_x->negate(); auto step1 = f_x->pow(step0); Erase(step0); return step1; }
+    Expr const* square() const override final;
+
+    Expr const* mul(Expr const*) const override final;
+    Expr const* commutative_mul(Expr const*) const override final;
+    Expr const* pow(Expr const* p) const override final { auto step0 = g_x->mul(p); auto step1 = f_x->pow(step0); Erase(step0); return step1; }
+
+    Expr const* binding(Substitution const& r) const override final
+    {
+        auto step0 = f_x->bind(r);
+        auto step1 = g_x->bind(r);
+        auto step2 = step0->pow(step1);
+
+        Erase(step0);
+        Erase(step1);
+
+        return step2;
+    }
+
+    bool is(NodeType t) const override final { return t == NodeType::POW; }
+    NodeType type() const override final { return NodeType::POW; }
+
+    bool attribute(Attr) const override final;
+    Interval interval() const override final;
+
+    Expr const* derivative(Variable const&) const override final;
+    Expr const* partial(int) const override final;
+    double value() const override final { return std::pow(f_x->evaluate(), g_x->evaluate()); }
+
+    void print(std::ostream&, std::vector<Token>&) const override final;
+
+private:
+    virtual ~Pow()
+    {
+        assert(lookup(NodeType::POW, f_x, g_x) == this);
+        leave(this, NodeType::POW, f_x, g_x);
     }
+};
 
-    auto node = powNode.find(p);
-    return node != powNode.end() ? Clone(node->second) : new Pow(Clone(this), Clone(p));
+/***********************************************************************************************************************
+*** abs()
+***********************************************************************************************************************/
+
+Expr const* Expression::data::abs() const
+{
+    if (guaranteed(Attr::NONNEGATIVE)) return Clone(this);
+    if (guaranteed(Attr::NONPOSITIVE)) return negate();
+    return function(NodeType::ABS);
 }
 
-Expr const* ConstantNode::pow(Expr const* p) const
+/***********************************************************************************************************************
+*** sgn()
+***********************************************************************************************************************/
+
+Expr const* Expression::data::sgn() const
 {
-    if (p->is(NodeType::CONSTANT)) return constant(std::pow(n, p->evaluate()));
-    if (n == 0 && p->guaranteed(Attr::NONZERO)) return Clone(this);
-    if (n == 1) return Clone(this);
-    if (n == std::exp(1)) return p->exp();
-    return Expr::pow(p);
+    if (guaranteed(Attr::POSITIVE)) return constant(1);
+    if (guaranteed(Attr::NEGATIVE)) return constant(-1);
+    return function(NodeType::SGN);
 }
 
-Expr const* Sqrt::pow(Expr const* p) const
+/***********************************************************************************************************************
+*** sqrt()
+***********************************************************************************************************************/
+
+Expr const* Pow::sqrt() const
 {
-    static ConstantNode inv2(1.0 / 2);
+    static Expr const& inv2 = *constant(1.0 / 2);
 
-    auto step0 = p->mul(inv2);
+    auto step0 = g_x->mul(inv2);
     auto step1 = f_x->pow(step0);
 
     Erase(step0);
@@ -1794,11 +2454,15 @@ Expr const* Sqrt::pow(Expr const* p) const
     return step1;
 }
 
-Expr const* Cbrt::pow(Expr const* p) const
+/***********************************************************************************************************************
+*** cbrt()
+***********************************************************************************************************************/
+
+Expr const* Pow::cbrt() const
 {
-    static ConstantNode inv3(1.0 / 3);
+    static Expr const& inv3 = *constant(1.0 / 3);
 
-    auto step0 = p->mul(inv3);
+    auto step0 = g_x->mul(inv3);
     auto step1 = f_x->pow(step0);
 
     Erase(step0);
@@ -1806,11 +2470,15 @@ Expr const* Cbrt::pow(Expr const* p) const
     return step1;
 }
 
-Expr const* Square::pow(Expr const* p) const
+/***********************************************************************************************************************
+*** square()
+***********************************************************************************************************************/
+
+Expr const* Pow::square() const
 {
-    static ConstantNode num2(2);
+    static Expr const& num2 = *constant(2);
 
-    auto step0 = p->mul(num2);
+    auto step0 = g_x->mul(num2);
     auto step1 = f_x->pow(step0);
 
     Erase(step0);
@@ -1819,290 +2487,363 @@ Expr const* Square::pow(Expr const* p) const
 }
 
 /***********************************************************************************************************************
-*** derivative()
+*** add()
 ***********************************************************************************************************************/
 
-Expr const* ConstantNode::derivative(Variable const&) const
+Expr const* Expression::data::add(Expr const* p) const
 {
-    // D(n) = 0
-
-    return constant(0);
+    return p->commutative_add(this);
 }
 
-Expr const* VariableNode::derivative(Variable const& r) const
+Expr const* Expression::data::commutative_add(Expr const* p) const
 {
-    // D(x) = 1 , D(?) = 0
-
-    return constant(r.id() == x.id());
+    return sum({ p, this });
 }
 
-Expr const* Abs::derivative(Variable const& r) const
+Expr const* Expression::data::sum(Terms terms)
 {
-    // D(abs(f_x)) = D(f_x) * sgn(f_x)
+    // Nested sums are flattened (as long as the result stays within 'MAXTERMS') and the constants are folded into one.
+    // The terms are sorted so that 'a+b+c' and 'c+a+b' are the same node.
 
-    auto step0 = f_x->sgn();
-    auto step1 = f_x->derive(r);
-    auto step2 = step0->mul(step1);
+    double n = 0;
 
+    for (size_t i = 0; i < terms.size(); )
+    {
+        auto p = terms[i];
 
-    Erase(step0);
-    Erase(step1);
+        if (p == &Nan::instance) return Clone(p);
 
-    return step2;
-}
+        auto const t = p->type();
 
-Expr const* Sgn::derivative(Variable const& r) const
-{
-    // D(sgn(f_x)) = D(f_x) * 0
+        if (t == NodeType::CONSTANT)
+        {
+            n += p->evaluate();
+        }
+        else if (t == NodeType::ADD && terms.size() + static_cast<ListNode const*>(p)->size() <= ListNode::MAXTERMS + 1)
+        {
+            for (int k = 0; auto q = p->operand(k); ++k) terms.push_back(q);
+        }
+        else
+        {
+            ++i;
+            continue;
+        }
 
-    return constant(0);
-}
+        terms[i] = terms.back();  // The order does not matter until sorted
+        terms.pop_back();
+    }
 
-Expr const* Sqrt::derivative(Variable const& r) const
-{
-    // D(sqrt(f_x)) = D(f_x) * 1/2 * 1/sqrt(f_x)
+    if (terms.empty() || isnan(n)) return constant(n);
+    if (terms.size() == 1 && n == 0) return Clone(terms[0]);
 
-    static ConstantNode inv2(1.0 / 2);
+    std::sort(terms.begin(), terms.end(), ListNode::precedes);
 
-    auto step0 = f_x->derive(r);
-    auto step1 = this->invert();
-    auto step2 = step1->mul(inv2);
-    auto step3 = step0->mul(step2);
+    auto step0 = n != 0 ? constant(n) : nullptr;
+    if (step0) terms.push_back(step0);  // The constant term goes last
 
-    Erase(step0);
-    Erase(step1);
-    Erase(step2);
+    Claim claim(stripe(NodeType::ADD, terms), [&] { return lookup(NodeType::ADD, terms); });
+    auto step1 = claim.node ? claim.node : new Add(terms);
 
-    return step3;
+    if (step0) Erase(step0);
+
+    return step1;
 }
 
-Expr const* Cbrt::derivative(Variable const& r) const
+Expr const* ConstantNode::add(Expr const* p) const
 {
-    // D(cbrt(f_x)) = D(f_x) * 1/3 * 1/cbrt(f_x)^2
-
-    static ConstantNode inv3(1.0 / 3);
+    if (p->is(NodeType::CONSTANT)) return constant(n + p->evaluate());
+    if (n == 0) return Clone(p);
+    return Expr::add(p);
+}
 
-    auto step0 = f_x->derive(r);
-    auto step1 = this->square();
-    auto step2 = step1->invert();
-    auto step3 = step2->mul(inv3);
-    auto step4 = step0->mul(step3);
-
-    Erase(step0);
-    Erase(step1);
-    Erase(step2);
-    Erase(step3);
-
-    return step4;
+Expr const* ConstantNode::commutative_add(Expr const* p) const
+{
+    if (p->is(NodeType::CONSTANT)) return constant(n + p->evaluate());
+    if (n == 0) return Clone(p);
+    return Expr::commutative_add(p);
 }
 
-Expr const* Exp::derivative(Variable const& r) const
+Expr const* Negate::add(Expr const* p) const
 {
-    // D(exp(f_x)) = D(f_x) * exp(f_x)
+    return Expr::add(p);
+}
 
-    auto step0 = f_x->derive(r);
-    auto step1 = step0->mul(this);
+/***********************************************************************************************************************
+*** mul()
+***********************************************************************************************************************/
 
-    Erase(step0);
+Expr const* Expression::data::mul(Expr const* p) const
+{
+    if (p == this) return square();
+    return p->commutative_mul(this);
+}
 
-    return step1;
+Expr const* Expression::data::commutative_mul(Expr const* p) const
+{
+    return product({ p, this });
 }
 
-Expr const* ExpM1::derivative(Variable const& r) const
+Expr const* Expression::data::product(Terms terms)
 {
-    // D(exp(f_x)-1) = D(f_x) * exp(f_x)
+    // Like 'sum()', with the constants folded into a coefficient that prunes the product when it is zero
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->exp();
-    auto step2 = step0->mul(step1);
+    double n = 1;
 
-    Erase(step0);
-    Erase(step1);
+    for (size_t i = 0; i < terms.size(); )
+    {
+        auto p = terms[i];
 
-    return step2;
-}
+        if (p == &Nan::instance) return Clone(p);
 
-Expr const* Log::derivative(Variable const& r) const
-{
-    // D(log(f_x)) = D(f_x) * 1/f_x
+        auto const t = p->type();
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->invert();
-    auto step2 = step0->mul(step1);
+        if (t == NodeType::CONSTANT)
+        {
+            auto d = p->evaluate();
+            n = n == 0 || d == 0 ? 0 : n * d;
+        }
+        else if (t == NodeType::MUL && terms.size() + static_cast<ListNode const*>(p)->size() <= ListNode::MAXTERMS + 1)
+        {
+            for (int k = 0; auto q = p->operand(k); ++k) terms.push_back(q);
+        }
+        else
+        {
+            ++i;
+            continue;
+        }
 
-    Erase(step0);
-    Erase(step1);
+        terms[i] = terms.back();
+        terms.pop_back();
+    }
 
-    return step2;
-}
+    if (terms.empty() || n == 0 || isnan(n)) return constant(n);
 
-Expr const* Log1P::derivative(Variable const& r) const
-{
-    // D(log(f_x+1)) = D(f_x) * 1/(f_x+1)
+    if (n == -1)
+    {
+        auto step0 = product(std::move(terms));
+        auto step1 = step0->negate();
 
-    static ConstantNode num1(1);
+        Erase(step0);
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->add(num1);
-    auto step2 = step1->invert();
-    auto step3 = step0->mul(step2);
+        return step1;
+    }
 
-    Erase(step0);
-    Erase(step1);
-    Erase(step2);
+    if (n == 1 && terms.size() == 1) return Clone(terms[0]);
+    if (n == 1 && terms.size() == 2 && terms[0] == terms[1]) return terms[0]->square();
 
-    return step3;
-}
+    std::sort(terms.begin(), terms.end(), ListNode::precedes);
 
-Expr const* Sin::derivative(Variable const& r) const
-{
-    // D(sin(f_x)) = D(f_x) * cos(f_x)
+    auto step0 = n != 1 ? constant(n) : nullptr;
+    if (step0) terms.insert(terms.begin(), step0);  // The coefficient goes first
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->cos();
-    auto step2 = step0->mul(step1);
+    Claim claim(stripe(NodeType::MUL, terms), [&] { return lookup(NodeType::MUL, terms); });
+    auto step1 = claim.node ? claim.node : new Mul(terms);
 
-    Erase(step0);
-    Erase(step1);
+    if (step0) Erase(step0);
 
-    return step2;
+    return step1;
 }
 
-Expr const* Cos::derivative(Variable const& r) const
+Expr const* ConstantNode::mul(Expr const* p) const
 {
-    // D(cos(f_x)) = D(f_x) * -sin(f_x)
+    if (p->is(NodeType::CONSTANT)) return constant(n * p->evaluate());
+    if (n == 0) return Clone(this);
+    if (n == 1) return Clone(p);
+    if (n == -1) return p->negate();
+    return Expr::mul(p);
+}
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->sin();
-    auto step2 = step1->negate();
-    auto step3 = step0->mul(step2);
+Expr const* ConstantNode::commutative_mul(Expr const* p) const
+{
+    if (p->is(NodeType::CONSTANT)) return constant(n * p->evaluate());
+    if (n == 0) return Clone(this);
+    if (n == 1) return Clone(p);
+    if (n == -1) return p->negate();
+    return Expr::commutative_mul(p);
+}
 
-    Erase(step0);
-    Erase(step1);
-    Erase(step2);
+Expr const* Invert::mul(Expr const* p) const
+{
+    if (p->easyInvert())  // 1/x * 1/p  ---->  1/(x * p)
+    {
+        auto step0 = p->invert();
+        auto step1 = f_x->mul(step0);
+        auto step2 = step1->invert();
+        Erase(step0);
+        Erase(step1);
+        return step2;
+    }
 
-    return step3;
+    return Expr::mul(p);
 }
 
-Expr const* Tan::derivative(Variable const& r) const
+Expr const* Negate::mul(Expr const* p) const
 {
-    // D(tan(f_x)) = D(f_x) * sec(f_x)^2
+    if (p->easyNegate())  // -x * -p  ---->  x * p
+    {
+        auto step0 = p->negate();
+        auto step1 = f_x->mul(step0);
+        Erase(step0);
+        return step1;
+    }
+    else  // -x * p  ---->  -(x * p)
+    {
+        auto step0 = f_x->mul(p);
+        auto step1 = step0->negate();
+        Erase(step0);
+        return step1;
+    }
+}
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->sec();
-    auto step2 = step1->square();
-    auto step3 = step0->mul(step2);
+Expr const* Pow::mul(Expr const* p) const
+{
+    static Expr const& num1 = *constant(1);
 
-    Erase(step0);
-    Erase(step1);
-    Erase(step2);
+    if (f_x == p)
+    {
+        auto step0 = g_x->add(num1);
+        auto step1 = f_x->pow(step0);
 
-    return step3;
+        Erase(step0);
+
+        return step1;
+    }
+
+    return Expr::mul(p);
 }
 
-Expr const* Sec::derivative(Variable const& r) const
+Expr const* Pow::commutative_mul(Expr const* p) const
 {
-    // D(sec(f_x)) = D(f_x) * tan(f_x)*sec(f_x)
+    static Expr const& num1 = *constant(1);
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->tan();
-    auto step2 = step1->mul(this);
-    auto step3 = step0->mul(step2);
+    if (f_x == p)
+    {
+        auto step0 = g_x->add(num1);
+        auto step1 = f_x->pow(step0);
 
-    Erase(step0);
-    Erase(step1);
-    Erase(step2);
+        Erase(step0);
 
-    return step3;
+        return step1;
+    }
+
+    return Expr::commutative_mul(p);
 }
 
-Expr const* ASin::derivative(Variable const& r) const
-{
-    // D(asin(f_x)) = D(f_x) * 1/sqrt(1-f_x^2)
+/***********************************************************************************************************************
+*** pow()
+***********************************************************************************************************************/
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->zconic();
-    auto step2 = step1->invert();
-    auto step3 = step0->mul(step2);
+Expr const* Expression::data::pow(Expr const* p) const
+{
+    if (p->is(NodeType::CONSTANT))
+    {
+        double n = p->evaluate();
+        if (n == 0) return constant(1);
+        if (n == 1) return Clone(this);
+        if (n == 2) return square();
+        if (n == -1) return invert();
+        if (n == 1.0 / 2.0) return sqrt();
+        if (n == 1.0 / 3.0) return cbrt();
+    }
 
-    Erase(step0);
-    Erase(step1);
-    Erase(step2);
+    Claim claim(stripe(NodeType::POW, this, p), [&] { return lookup(NodeType::POW, this, p); });
+    return claim.node ? claim.node : new Pow(Clone(this), Clone(p));
+}
 
-    return step3;
+Expr const* ConstantNode::pow(Expr const* p) const
+{
+    if (p->is(NodeType::CONSTANT)) return constant(std::pow(n, p->evaluate()));
+    if (n == 0 && p->guaranteed(Attr::NONZERO)) return Clone(this);
+    if (n == 1) return Clone(this);
+    if (n == std::exp(1)) return p->exp();
+    return Expr::pow(p);
 }
 
-Expr const* ACos::derivative(Variable const& r) const
+Expr const* Sqrt::pow(Expr const* p) const
 {
-    // D(acos(f_x)) = D(f_x) * -1/sqrt(1-f_x^2)
+    static Expr const& inv2 = *constant(1.0 / 2);
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->zconic();
-    auto step2 = step1->invert();
-    auto step3 = step2->negate();
-    auto step4 = step0->mul(step3);
+    auto step0 = p->mul(inv2);
+    auto step1 = f_x->pow(step0);
 
     Erase(step0);
-    Erase(step1);
-    Erase(step2);
-    Erase(step3);
 
-    return step4;
+    return step1;
 }
 
-Expr const* ATan::derivative(Variable const& r) const
+Expr const* Cbrt::pow(Expr const* p) const
 {
-    // D(atan(f_x)) = D(f_x) * 1/(f_x^2+1)
+    static Expr const& inv3 = *constant(1.0 / 3);
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->yconic();
-    auto step2 = step1->square();
-    auto step3 = step2->invert();
-    auto step4 = step0->mul(step3);
+    auto step0 = p->mul(inv3);
+    auto step1 = f_x->pow(step0);
 
     Erase(step0);
-    Erase(step1);
-    Erase(step2);
-    Erase(step3);
 
-    return step4;
+    return step1;
 }
 
-Expr const* SinH::derivative(Variable const& r) const
+Expr const* Square::pow(Expr const* p) const
 {
-    // D(sinh(f_x)) = D(f_x) * cosh(f_x)
+    static Expr const& num2 = *constant(2);
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->cosh();
-    auto step2 = step0->mul(step1);
+    auto step0 = p->mul(num2);
+    auto step1 = f_x->pow(step0);
 
     Erase(step0);
-    Erase(step1);
 
-    return step2;
+    return step1;
 }
 
-Expr const* CosH::derivative(Variable const& r) const
+/***********************************************************************************************************************
+*** derivative()
+***********************************************************************************************************************/
+
+Expr const* ConstantNode::derivative(Variable const&) const
 {
-    // D(cosh(f_x)) = D(f_x) * sinh(f_x)
+    // D(n) = 0
 
-    auto step0 = f_x->derive(r);
-    auto step1 = f_x->sinh();
+    return constant(0);
+}
+
+Expr const* VariableNode::derivative(Variable const& r) const
+{
+    // D(x) = 1 , D(?) = 0
+
+    return constant(r.id() == x.id());
+}
+
+Expr const* Abs::derivative(Variable const& r) const
+{
+    // D(abs(f_x)) = D(f_x) * sgn(f_x)
+
+    auto step0 = f_x->sgn();
+    auto step1 = f_x->derive(r);
     auto step2 = step0->mul(step1);
 
+
     Erase(step0);
     Erase(step1);
 
     return step2;
 }
 
-Expr const* TanH::derivative(Variable const& r) const
+Expr const* Sgn::derivative(Variable const& r) const
 {
-    // D(tanh(f_x)) = D(f_x) * sech(f_x)^2
+    // D(sgn(f_x)) = D(f_x) * 0
+
+    return constant(0);
+}
+
+Expr const* Sqrt::derivative(Variable const& r) const
+{
+    // D(sqrt(f_x)) = D(f_x) * 1/2 * 1/sqrt(f_x)
+
+    static Expr const& inv2 = *constant(1.0 / 2);
 
     auto step0 = f_x->derive(r);
-    auto step1 = f_x->sech();
-    auto step2 = step1->square();
+    auto step1 = this->invert();
+    auto step2 = step1->mul(inv2);
     auto step3 = step0->mul(step2);
 
     Erase(step0);
@@ -2112,14 +2853,16 @@ Expr const* TanH::derivative(Variable const& r) const
     return step3;
 }
 
-Expr const* SecH::derivative(Variable const& r) const
+Expr const* Cbrt::derivative(Variable const& r) const
 {
-    // D(sech(f_x)) = D(f_x) * -tanh(f_x)*sech(f_x)
+    // D(cbrt(f_x)) = D(f_x) * 1/3 * 1/cbrt(f_x)^2
+
+    static Expr const& inv3 = *constant(1.0 / 3);
 
     auto step0 = f_x->derive(r);
-    auto step1 = f_x->tanh();
-    auto step2 = step1->mul(this);
-    auto step3 = step2->negate();
+    auto step1 = this->square();
+    auto step2 = step1->invert();
+    auto step3 = step2->mul(inv3);
     auto step4 = step0->mul(step3);
 
     Erase(step0);
@@ -2130,107 +2873,101 @@ Expr const* SecH::derivative(Variable const& r) const
     return step4;
 }
 
-Expr const* ASinH::derivative(Variable const& r) const
+Expr const* Exp::derivative(Variable const& r) const
 {
-    // D(asinh(f_x)) = D(f_x) * 1/sqrt(f_x^2+1)
+    // D(exp(f_x)) = D(f_x) * exp(f_x)
 
     auto step0 = f_x->derive(r);
-    auto step1 = f_x->yconic();
-    auto step2 = step1->invert();
-    auto step3 = step0->mul(step2);
+    auto step1 = step0->mul(this);
 
     Erase(step0);
-    Erase(step1);
-    Erase(step2);
 
-    return step3;
+    return step1;
 }
 
-Expr const* ACosH::derivative(Variable const& r) const
+Expr const* ExpM1::derivative(Variable const& r) const
 {
-    // D(acosh(f_x)) = D(f_x) * 1/sqrt(f_x^2-1)
+    // D(exp(f_x)-1) = D(f_x) * exp(f_x)
 
     auto step0 = f_x->derive(r);
-    auto step1 = f_x->xconic();
-    auto step2 = step1->invert();
-    auto step3 = step0->mul(step2);
+    auto step1 = f_x->exp();
+    auto step2 = step0->mul(step1);
 
     Erase(step0);
     Erase(step1);
-    Erase(step2);
 
-    return step3;
+    return step2;
 }
 
-Expr const* ATanH::derivative(Variable const& r) const
+Expr const* Log::derivative(Variable const& r) const
 {
-    // D(atanh(f_x)) = D(f_x) * 1/(1-f_x^2)
+    // D(log(f_x)) = D(f_x) * 1/f_x
 
     auto step0 = f_x->derive(r);
-    auto step1 = f_x->zconic();
-    auto step2 = step1->square();
-    auto step3 = step2->invert();
-    auto step4 = step0->mul(step3);
+    auto step1 = f_x->invert();
+    auto step2 = step0->mul(step1);
 
     Erase(step0);
     Erase(step1);
-    Erase(step2);
-    Erase(step3);
 
-    return step4;
+    return step2;
 }
 
-Expr const* Erf::derivative(Variable const& r) const
+Expr const* Log1P::derivative(Variable const& r) const
 {
-    ConstantNode InvSqrtAtan1(1 / std::sqrt(std::atan(1)));
+    // D(log(f_x+1)) = D(f_x) * 1/(f_x+1)
 
-    // D(erf(f_x)) = D(f_x) * 1/exp(f_x^2) * 1/sqrt(atan(1))
+    static Expr const& num1 = *constant(1);
 
     auto step0 = f_x->derive(r);
-    auto step1 = f_x->square();
-    auto step2 = step1->exp();
-    auto step3 = step2->invert();
-    auto step4 = step3->mul(InvSqrtAtan1);
-    auto step5 = step0->mul(step4);
+    auto step1 = f_x->add(num1);
+    auto step2 = step1->invert();
+    auto step3 = step0->mul(step2);
 
     Erase(step0);
     Erase(step1);
     Erase(step2);
-    Erase(step3);
-    Erase(step4);
 
-    return step5;
+    return step3;
 }
 
-Expr const* ErfC::derivative(Variable const& r) const
+Expr const* Sin::derivative(Variable const& r) const
 {
-    ConstantNode NegInvSqrtAtan1(-1 / std::sqrt(std::atan(1)));
+    // D(sin(f_x)) = D(f_x) * cos(f_x)
 
-    // D(erfc(f_x)) = D(f_x) * 1/exp(f_x^2) * -1/sqrt(atan(1))
+    auto step0 = f_x->derive(r);
+    auto step1 = f_x->cos();
+    auto step2 = step0->mul(step1);
+
+    Erase(step0);
+    Erase(step1);
+
+    return step2;
+}
+
+Expr const* Cos::derivative(Variable const& r) const
+{
+    // D(cos(f_x)) = D(f_x) * -sin(f_x)
 
     auto step0 = f_x->derive(r);
-    auto step1 = f_x->square();
-    auto step2 = step1->exp();
-    auto step3 = step2->invert();
-    auto step4 = step3->mul(NegInvSqrtAtan1);
-    auto step5 = step0->mul(step4);
+    auto step1 = f_x->sin();
+    auto step2 = step1->negate();
+    auto step3 = step0->mul(step2);
 
     Erase(step0);
     Erase(step1);
     Erase(step2);
-    Erase(step3);
-    Erase(step4);
 
-    return step5;
+    return step3;
 }
 
-Expr const* Invert::derivative(Variable const& r) const
+Expr const* Tan::derivative(Variable const& r) const
 {
-    // D(1/f_x) = D(f_x) * -(1/f_x)^2
+    // D(tan(f_x)) = D(f_x) * sec(f_x)^2
 
     auto step0 = f_x->derive(r);
-    auto step1 = this->square();
-    auto step2 = step1->negate();
+    auto step1 = f_x->sec();
+    auto step2 = step1->square();
     auto step3 = step0->mul(step2);
 
     Erase(step0);
@@ -2240,25 +2977,29 @@ Expr const* Invert::derivative(Variable const& r) const
     return step3;
 }
 
-Expr const* Negate::derivative(Variable const& r) const
+Expr const* Sec::derivative(Variable const& r) const
 {
-    // D(-f_x) = D(f_x) * -1
+    // D(sec(f_x)) = D(f_x) * tan(f_x)*sec(f_x)
 
     auto step0 = f_x->derive(r);
-    auto step1 = step0->negate();
+    auto step1 = f_x->tan();
+    auto step2 = step1->mul(this);
+    auto step3 = step0->mul(step2);
 
     Erase(step0);
+    Erase(step1);
+    Erase(step2);
 
-    return step1;
+    return step3;
 }
 
-Expr const* SoftPP::derivative(Variable const& r) const
+Expr const* ASin::derivative(Variable const& r) const
 {
-    // D(-Li2(-exp(f_x))) = D(f_x) * log(1+exp(f_x))
+    // D(asin(f_x)) = D(f_x) * 1/sqrt(1-f_x^2)
 
     auto step0 = f_x->derive(r);
-    auto step1 = f_x->exp();
-    auto step2 = step1->log1p();
+    auto step1 = f_x->zconic();
+    auto step2 = step1->invert();
     auto step3 = step0->mul(step2);
 
     Erase(step0);
@@ -2268,34 +3009,48 @@ Expr const* SoftPP::derivative(Variable const& r) const
     return step3;
 }
 
-Expr const* Spence::derivative(Variable const& r) const
+Expr const* ACos::derivative(Variable const& r) const
 {
-    // D(Li2(f_x)) = D(f_x) * log(1-f_x)/(-f_x)
+    // D(acos(f_x)) = D(f_x) * -1/sqrt(1-f_x^2)
 
     auto step0 = f_x->derive(r);
-    auto step1 = f_x->negate();
-    auto step2 = step1->log1p();
-    auto step3 = step1->invert();
-    auto step4 = step2->mul(step3);
-    auto step5 = step0->mul(step4);
+    auto step1 = f_x->zconic();
+    auto step2 = step1->invert();
+    auto step3 = step2->negate();
+    auto step4 = step0->mul(step3);
 
     Erase(step0);
     Erase(step1);
     Erase(step2);
     Erase(step3);
-    Erase(step4);
 
-    return step5;
+    return step4;
 }
 
-Expr const* Square::derivative(Variable const& r) const
+Expr const* ATan::derivative(Variable const& r) const
 {
-    // D(f_x^2) = D(f_x) * 2*f_x
+    // D(atan(f_x)) = D(f_x) * 1/(f_x^2+1)
+
+    auto step0 = f_x->derive(r);
+    auto step1 = f_x->yconic();
+    auto step2 = step1->square();
+    auto step3 = step2->invert();
+    auto step4 = step0->mul(step3);
+
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
+    Erase(step3);
+
+    return step4;
+}
 
-    static ConstantNode num2(2);
+Expr const* SinH::derivative(Variable const& r) const
+{
+    // D(sinh(f_x)) = D(f_x) * cosh(f_x)
 
     auto step0 = f_x->derive(r);
-    auto step1 = f_x->mul(num2);
+    auto step1 = f_x->cosh();
     auto step2 = step0->mul(step1);
 
     Erase(step0);
@@ -2304,29 +3059,27 @@ Expr const* Square::derivative(Variable const& r) const
     return step2;
 }
 
-Expr const* XConic::derivative(Variable const& r) const
+Expr const* CosH::derivative(Variable const& r) const
 {
-    // D(sqrt(f_x^2-1)) = D(f_x) * f_x / sqrt(f_x^2-1)
+    // D(cosh(f_x)) = D(f_x) * sinh(f_x)
 
     auto step0 = f_x->derive(r);
-    auto step1 = this->invert();
-    auto step2 = step1->mul(f_x);
-    auto step3 = step0->mul(step2);
+    auto step1 = f_x->sinh();
+    auto step2 = step0->mul(step1);
 
     Erase(step0);
     Erase(step1);
-    Erase(step2);
 
-    return step3;
+    return step2;
 }
 
-Expr const* YConic::derivative(Variable const& r) const
+Expr const* TanH::derivative(Variable const& r) const
 {
-    // D(sqrt(f_x^2+1)) = D(f_x) * f_x / sqrt(f_x^2+1)
+    // D(tanh(f_x)) = D(f_x) * sech(f_x)^2
 
     auto step0 = f_x->derive(r);
-    auto step1 = this->invert();
-    auto step2 = step1->mul(f_x);
+    auto step1 = f_x->sech();
+    auto step2 = step1->square();
     auto step3 = step0->mul(step2);
 
     Erase(step0);
@@ -2336,13 +3089,13 @@ Expr const* YConic::derivative(Variable const& r) const
     return step3;
 }
 
-Expr const* ZConic::derivative(Variable const& r) const
+Expr const* SecH::derivative(Variable const& r) const
 {
-    // D(sqrt(1-f_x^2)) = D(f_x) * -f_x / sqrt(1-f_x^2)
+    // D(sech(f_x)) = D(f_x) * -tanh(f_x)*sech(f_x)
 
     auto step0 = f_x->derive(r);
-    auto step1 = this->invert();
-    auto step2 = step1->mul(f_x);
+    auto step1 = f_x->tanh();
+    auto step2 = step1->mul(this);
     auto step3 = step2->negate();
     auto step4 = step0->mul(step3);
 
@@ -2354,1566 +3107,4023 @@ Expr const* ZConic::derivative(Variable const& r) const
     return step4;
 }
 
-Expr const* Add::derivative(Variable const& r) const
+Expr const* ASinH::derivative(Variable const& r) const
 {
-    // D(f_x+g_x) = D(f_x) + D(g_x)
+    // D(asinh(f_x)) = D(f_x) * 1/sqrt(f_x^2+1)
 
     auto step0 = f_x->derive(r);
-    auto step1 = g_x->derive(r);
-    auto step2 = step0->add(step1);
+    auto step1 = f_x->yconic();
+    auto step2 = step1->invert();
+    auto step3 = step0->mul(step2);
 
     Erase(step0);
     Erase(step1);
+    Erase(step2);
 
-    return step2;
+    return step3;
 }
 
-Expr const* Mul::derivative(Variable const& r) const
+Expr const* ACosH::derivative(Variable const& r) const
 {
-    // D(f_x*g_x) = D(f_x) * g_x + D(g_x) * f_x
+    // D(acosh(f_x)) = D(f_x) * 1/sqrt(f_x^2-1)
 
     auto step0 = f_x->derive(r);
-    auto step1 = g_x->derive(r);
-    auto step2 = f_x->mul(step1);
-    auto step3 = g_x->mul(step0);
-    auto step4 = step2->add(step3);
+    auto step1 = f_x->xconic();
+    auto step2 = step1->invert();
+    auto step3 = step0->mul(step2);
 
     Erase(step0);
     Erase(step1);
     Erase(step2);
-    Erase(step3);
 
-    return step4;
+    return step3;
 }
 
-Expr const* Pow::derivative(Variable const& r) const
+Expr const* ATanH::derivative(Variable const& r) const
 {
-    // D(f_x^g_x) = D(f_x) * g_x*f_x^(g_x-1) + D(g_x) * f_x^g_x*log(f_x)
-
-    static ConstantNode neg1(-1);
+    // D(atanh(f_x)) = D(f_x) * 1/(1-f_x^2)
 
     auto step0 = f_x->derive(r);
-    auto step1 = g_x->derive(r);
-    auto step2 = f_x->log();
-    auto step3 = g_x->add(neg1);
-    auto step4 = f_x->pow(step3);
-    auto step5 = g_x->mul(step4);
-    auto step6 = this->mul(step2);
-    auto step7 = step0->mul(step5);
-    auto step8 = step1->mul(step6);
-    auto step9 = step7->add(step8);
+    auto step1 = f_x->zconic();
+    auto step2 = step1->square();
+    auto step3 = step2->invert();
+    auto step4 = step0->mul(step3);
 
     Erase(step0);
     Erase(step1);
     Erase(step2);
     Erase(step3);
-    Erase(step4);
-    Erase(step5);
-    Erase(step6);
-    Erase(step7);
-    Erase(step8);
 
-    return step9;
+    return step4;
 }
 
-/***********************************************************************************************************************
-*** value()
-***********************************************************************************************************************/
-
-double Mul::value() const
+Expr const* Erf::derivative(Variable const& r) const
 {
-    // NOTE: All of '0*inf', '0*nan', 'inf*0', 'nan*0' deliberately evaluate as '0'
-    // The purpose is to be able to prune [possibly undefined] branches of the expression tree by using a variable
-    // and giving it a value '1' (=use the multiplicand) or '0' (=prune the expression contained by multiplicand)
+    static Expr const& InvSqrtAtan1 = *constant(1 / std::sqrt(std::atan(1)));
 
-    auto x = f_x->evaluate();
-    if (x == 0) return 0;
-    auto y = g_x->evaluate();
-    if (y == 0) return 0;
-    return x * y;
-}
+    // D(erf(f_x)) = D(f_x) * 1/exp(f_x^2) * 1/sqrt(atan(1))
 
-/***********************************************************************************************************************
-*** guaranteed()
-***********************************************************************************************************************/
+    auto step0 = f_x->derive(r);
+    auto step1 = f_x->square();
+    auto step2 = step1->exp();
+    auto step3 = step2->invert();
+    auto step4 = step3->mul(InvSqrtAtan1);
+    auto step5 = step0->mul(step4);
 
-/*
-bool <generic>::guaranteed(Attr a) const
-{
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::UNITRANGE:
-    case Attr::ANTIUNITRANGE:
-    case Attr::OPENUNITRANGE:
-    case Attr::ANTIOPENUNITRANGE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        ;
-    }
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
+    Erase(step3);
+    Erase(step4);
 
-    return false;
+    return step5;
 }
-*/
 
-bool ConstantNode::guaranteed(Attr a) const
+Expr const* ErfC::derivative(Variable const& r) const
 {
-    if (!isnan(n) && !isinf(n)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::CONTINUOUS:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
-
-    case Attr::NONZERO:
-        return n != 0;
-
-    case Attr::POSITIVE:
-        return n > 0;
+    static Expr const& NegInvSqrtAtan1 = *constant(-1 / std::sqrt(std::atan(1)));
 
-    case Attr::NEGATIVE:
-        return n < 0;
+    // D(erfc(f_x)) = D(f_x) * 1/exp(f_x^2) * -1/sqrt(atan(1))
 
-    case Attr::NONPOSITIVE:
-        return n <= 0;
+    auto step0 = f_x->derive(r);
+    auto step1 = f_x->square();
+    auto step2 = step1->exp();
+    auto step3 = step2->invert();
+    auto step4 = step3->mul(NegInvSqrtAtan1);
+    auto step5 = step0->mul(step4);
 
-    case Attr::NONNEGATIVE:
-        return n >= 0;
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
+    Erase(step3);
+    Erase(step4);
 
-    case Attr::UNITRANGE:
-        return n >= -1 && n <= 1;
+    return step5;
+}
 
-    case Attr::ANTIUNITRANGE:
-        return n < -1 || n > 1;
+Expr const* Invert::derivative(Variable const& r) const
+{
+    // D(1/f_x) = D(f_x) * -(1/f_x)^2
 
-    case Attr::OPENUNITRANGE:
-        return n > -1 && n < 1;
+    auto step0 = f_x->derive(r);
+    auto step1 = this->square();
+    auto step2 = step1->negate();
+    auto step3 = step0->mul(step2);
 
-    case Attr::ANTIOPENUNITRANGE:
-        return n <= -1 || n >= 1;
-    }
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
 
-    return false;
+    return step3;
 }
 
-bool VariableNode::guaranteed(Attr a) const
+Expr const* Negate::derivative(Variable const& r) const
 {
-    switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::NONDECREASING:
-        return true;
-    }
+    // D(-f_x) = D(f_x) * -1
 
-    return false;
+    auto step0 = f_x->derive(r);
+    auto step1 = step0->negate();
+
+    Erase(step0);
+
+    return step1;
 }
 
-bool Abs::guaranteed(Attr a) const
+Expr const* SoftPP::derivative(Variable const& r) const
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::NONNEGATIVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
-
-    case Attr::NONZERO:
-    case Attr::UNITRANGE:
-    case Attr::ANTIUNITRANGE:
-    case Attr::OPENUNITRANGE:
-    case Attr::ANTIOPENUNITRANGE:
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a);
+    // D(-Li2(-exp(f_x))) = D(f_x) * log(1+exp(f_x))
 
-    case Attr::POSITIVE:
-        return f_x->guaranteed(Attr::NONZERO);
+    auto step0 = f_x->derive(r);
+    auto step1 = f_x->exp();
+    auto step2 = step1->log1p();
+    auto step3 = step0->mul(step2);
 
-    case Attr::INCREASING:
-        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
-        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
-        return false;
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
 
-    case Attr::DECREASING:
-        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
-        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
-        return false;
+    return step3;
+}
 
-    case Attr::NONINCREASING:
-        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        return false;
+Expr const* Spence::derivative(Variable const& r) const
+{
+    // D(Li2(f_x)) = D(f_x) * log(1-f_x)/(-f_x)
 
-    case Attr::NONDECREASING:
-        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        return false;
+    auto step0 = f_x->derive(r);
+    auto step1 = f_x->negate();
+    auto step2 = step1->log1p();
+    auto step3 = step1->invert();
+    auto step4 = step2->mul(step3);
+    auto step5 = step0->mul(step4);
 
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(Attr::BOUNDEDABOVE) && f_x->guaranteed(Attr::BOUNDEDBELOW);
-    }
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
+    Erase(step3);
+    Erase(step4);
 
-    return false;
+    return step5;
 }
 
-bool Sgn::guaranteed(Attr a) const
+Expr const* Square::derivative(Variable const& r) const
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::UNITRANGE:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+    // D(f_x^2) = D(f_x) * 2*f_x
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-        return f_x->guaranteed(a);
+    static Expr const& num2 = *constant(2);
 
-    case Attr::ANTIOPENUNITRANGE:
-        return f_x->guaranteed(Attr::NONZERO);
+    auto step0 = f_x->derive(r);
+    auto step1 = f_x->mul(num2);
+    auto step2 = step0->mul(step1);
 
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE);
+    Erase(step0);
+    Erase(step1);
 
-    case Attr::NONINCREASING:
-        return f_x->guaranteed(Attr::NONINCREASING) || f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE);
+    return step2;
+}
 
-    case Attr::NONDECREASING:
-        return f_x->guaranteed(Attr::NONDECREASING) || f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE);
-    }
+Expr const* XConic::derivative(Variable const& r) const
+{
+    // D(sqrt(f_x^2-1)) = D(f_x) * f_x / sqrt(f_x^2-1)
 
-    return false;
+    auto step0 = f_x->derive(r);
+    auto step1 = this->invert();
+    auto step2 = step1->mul(f_x);
+    auto step3 = step0->mul(step2);
+
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
+
+    return step3;
 }
 
-bool Sqrt::guaranteed(Attr a) const
+Expr const* YConic::derivative(Variable const& r) const
+{
+    // D(sqrt(f_x^2+1)) = D(f_x) * f_x / sqrt(f_x^2+1)
+
+    auto step0 = f_x->derive(r);
+    auto step1 = this->invert();
+    auto step2 = step1->mul(f_x);
+    auto step3 = step0->mul(step2);
+
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
+
+    return step3;
+}
+
+Expr const* ZConic::derivative(Variable const& r) const
+{
+    // D(sqrt(1-f_x^2)) = D(f_x) * -f_x / sqrt(1-f_x^2)
+
+    auto step0 = f_x->derive(r);
+    auto step1 = this->invert();
+    auto step2 = step1->mul(f_x);
+    auto step3 = step2->negate();
+    auto step4 = step0->mul(step3);
+
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
+    Erase(step3);
+
+    return step4;
+}
+
+Expr const* Add::derivative(Variable const& r) const
+{
+    // D(f_1+...+f_n) = D(f_1) + ... + D(f_n)
+
+    Terms step0;
+    for (auto p : terms) step0.push_back(p->derive(r));
+    auto step1 = sum(step0);
+
+    for (auto p : step0) Erase(p);
+
+    return step1;
+}
+
+Expr const* Mul::derivative(Variable const& r) const
+{
+    // D(f_1*...*f_n) = D(f_1) * f_2*...*f_n + ... + D(f_n) * f_1*...*f_(n-1) , where only the terms that depend on the
+    // variable have a nonzero derivative
+
+    Terms step0;
+
+    for (size_t i = 0; i < terms.size(); ++i)
+    {
+        auto step1 = terms[i]->derive(r);
+
+        if (!step1->is(NodeType::CONSTANT) || step1->evaluate() != 0)
+        {
+            Terms step2(terms.begin(), terms.end());
+            step2[i] = step1;
+            step0.push_back(product(step2));
+        }
+
+        Erase(step1);
+    }
+
+    auto step3 = sum(step0);
+
+    for (auto p : step0) Erase(p);
+
+    return step3;
+}
+
+Expr const* Pow::derivative(Variable const& r) const
+{
+    // D(f_x^g_x) = D(f_x) * g_x*f_x^(g_x-1) + D(g_x) * f_x^g_x*log(f_x)
+
+    static Expr const& neg1 = *constant(-1);
+
+    auto step0 = f_x->derive(r);
+    auto step1 = g_x->derive(r);
+    auto step2 = f_x->log();
+    auto step3 = g_x->add(neg1);
+    auto step4 = f_x->pow(step3);
+    auto step5 = g_x->mul(step4);
+    auto step6 = this->mul(step2);
+    auto step7 = step0->mul(step5);
+    auto step8 = step1->mul(step6);
+    auto step9 = step7->add(step8);
+
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
+    Erase(step3);
+    Erase(step4);
+    Erase(step5);
+    Erase(step6);
+    Erase(step7);
+    Erase(step8);
+
+    return step9;
+}
+
+/***********************************************************************************************************************
+*** partial()
+***********************************************************************************************************************/
+
+Expr const* Abs::partial(int) const
+{
+    // d(abs(f_x))/d(f_x) = sgn(f_x)
+
+    return f_x->sgn();
+}
+
+Expr const* Sgn::partial(int) const
+{
+    // d(sgn(f_x))/d(f_x) = 0
+
+    return constant(0);
+}
+
+Expr const* Sqrt::partial(int) const
+{
+    // d(sqrt(f_x))/d(f_x) = 1/2 * 1/sqrt(f_x)
+
+    static Expr const& inv2 = *constant(1.0 / 2);
+
+    auto step0 = this->invert();
+    auto step1 = step0->mul(inv2);
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* Cbrt::partial(int) const
+{
+    // d(cbrt(f_x))/d(f_x) = 1/3 * 1/cbrt(f_x)^2
+
+    static Expr const& inv3 = *constant(1.0 / 3);
+
+    auto step0 = this->square();
+    auto step1 = step0->invert();
+    auto step2 = step1->mul(inv3);
+
+    Erase(step0);
+    Erase(step1);
+
+    return step2;
+}
+
+Expr const* Exp::partial(int) const
+{
+    // d(exp(f_x))/d(f_x) = exp(f_x)
+
+    return Clone(this);
+}
+
+Expr const* ExpM1::partial(int) const
+{
+    // d(exp(f_x)-1)/d(f_x) = exp(f_x)
+
+    return f_x->exp();
+}
+
+Expr const* Log::partial(int) const
+{
+    // d(log(f_x))/d(f_x) = 1/f_x
+
+    return f_x->invert();
+}
+
+Expr const* Log1P::partial(int) const
+{
+    // d(log(f_x+1))/d(f_x) = 1/(f_x+1)
+
+    static Expr const& num1 = *constant(1);
+
+    auto step0 = f_x->add(num1);
+    auto step1 = step0->invert();
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* Sin::partial(int) const
+{
+    // d(sin(f_x))/d(f_x) = cos(f_x)
+
+    return f_x->cos();
+}
+
+Expr const* Cos::partial(int) const
+{
+    // d(cos(f_x))/d(f_x) = -sin(f_x)
+
+    auto step0 = f_x->sin();
+    auto step1 = step0->negate();
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* Tan::partial(int) const
+{
+    // d(tan(f_x))/d(f_x) = sec(f_x)^2
+
+    auto step0 = f_x->sec();
+    auto step1 = step0->square();
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* Sec::partial(int) const
+{
+    // d(sec(f_x))/d(f_x) = tan(f_x)*sec(f_x)
+
+    auto step0 = f_x->tan();
+    auto step1 = step0->mul(this);
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* ASin::partial(int) const
+{
+    // d(asin(f_x))/d(f_x) = 1/sqrt(1-f_x^2)
+
+    auto step0 = f_x->zconic();
+    auto step1 = step0->invert();
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* ACos::partial(int) const
+{
+    // d(acos(f_x))/d(f_x) = -1/sqrt(1-f_x^2)
+
+    auto step0 = f_x->zconic();
+    auto step1 = step0->invert();
+    auto step2 = step1->negate();
+
+    Erase(step0);
+    Erase(step1);
+
+    return step2;
+}
+
+Expr const* ATan::partial(int) const
+{
+    // d(atan(f_x))/d(f_x) = 1/(f_x^2+1)
+
+    auto step0 = f_x->yconic();
+    auto step1 = step0->square();
+    auto step2 = step1->invert();
+
+    Erase(step0);
+    Erase(step1);
+
+    return step2;
+}
+
+Expr const* SinH::partial(int) const
+{
+    // d(sinh(f_x))/d(f_x) = cosh(f_x)
+
+    return f_x->cosh();
+}
+
+Expr const* CosH::partial(int) const
+{
+    // d(cosh(f_x))/d(f_x) = sinh(f_x)
+
+    return f_x->sinh();
+}
+
+Expr const* TanH::partial(int) const
+{
+    // d(tanh(f_x))/d(f_x) = sech(f_x)^2
+
+    auto step0 = f_x->sech();
+    auto step1 = step0->square();
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* SecH::partial(int) const
+{
+    // d(sech(f_x))/d(f_x) = -tanh(f_x)*sech(f_x)
+
+    auto step0 = f_x->tanh();
+    auto step1 = step0->mul(this);
+    auto step2 = step1->negate();
+
+    Erase(step0);
+    Erase(step1);
+
+    return step2;
+}
+
+Expr const* ASinH::partial(int) const
+{
+    // d(asinh(f_x))/d(f_x) = 1/sqrt(f_x^2+1)
+
+    auto step0 = f_x->yconic();
+    auto step1 = step0->invert();
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* ACosH::partial(int) const
+{
+    // d(acosh(f_x))/d(f_x) = 1/sqrt(f_x^2-1)
+
+    auto step0 = f_x->xconic();
+    auto step1 = step0->invert();
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* ATanH::partial(int) const
+{
+    // d(atanh(f_x))/d(f_x) = 1/(1-f_x^2)
+
+    auto step0 = f_x->zconic();
+    auto step1 = step0->square();
+    auto step2 = step1->invert();
+
+    Erase(step0);
+    Erase(step1);
+
+    return step2;
+}
+
+Expr const* Erf::partial(int) const
+{
+    // d(erf(f_x))/d(f_x) = 1/exp(f_x^2) * 1/sqrt(atan(1))
+
+    static Expr const& InvSqrtAtan1 = *constant(1 / std::sqrt(std::atan(1)));
+
+    auto step0 = f_x->square();
+    auto step1 = step0->exp();
+    auto step2 = step1->invert();
+    auto step3 = step2->mul(InvSqrtAtan1);
+
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
+
+    return step3;
+}
+
+Expr const* ErfC::partial(int) const
+{
+    // d(erfc(f_x))/d(f_x) = 1/exp(f_x^2) * -1/sqrt(atan(1))
+
+    static Expr const& NegInvSqrtAtan1 = *constant(-1 / std::sqrt(std::atan(1)));
+
+    auto step0 = f_x->square();
+    auto step1 = step0->exp();
+    auto step2 = step1->invert();
+    auto step3 = step2->mul(NegInvSqrtAtan1);
+
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
+
+    return step3;
+}
+
+Expr const* Invert::partial(int) const
+{
+    // d(1/f_x)/d(f_x) = -(1/f_x)^2
+
+    auto step0 = this->square();
+    auto step1 = step0->negate();
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* Negate::partial(int) const
+{
+    // d(-f_x)/d(f_x) = -1
+
+    return constant(-1);
+}
+
+Expr const* SoftPP::partial(int) const
+{
+    // d(-Li2(-exp(f_x)))/d(f_x) = log(1+exp(f_x))
+
+    auto step0 = f_x->exp();
+    auto step1 = step0->log1p();
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* Spence::partial(int) const
+{
+    // d(Li2(f_x))/d(f_x) = log(1-f_x)/(-f_x)
+
+    auto step0 = f_x->negate();
+    auto step1 = step0->log1p();
+    auto step2 = step0->invert();
+    auto step3 = step1->mul(step2);
+
+    Erase(step0);
+    Erase(step1);
+    Erase(step2);
+
+    return step3;
+}
+
+Expr const* Square::partial(int) const
+{
+    // d(f_x^2)/d(f_x) = 2*f_x
+
+    static Expr const& num2 = *constant(2);
+
+    return f_x->mul(num2);
+}
+
+Expr const* XConic::partial(int) const
+{
+    // d(sqrt(f_x^2-1))/d(f_x) = f_x / sqrt(f_x^2-1)
+
+    auto step0 = this->invert();
+    auto step1 = step0->mul(f_x);
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* YConic::partial(int) const
+{
+    // d(sqrt(f_x^2+1))/d(f_x) = f_x / sqrt(f_x^2+1)
+
+    auto step0 = this->invert();
+    auto step1 = step0->mul(f_x);
+
+    Erase(step0);
+
+    return step1;
+}
+
+Expr const* ZConic::partial(int) const
+{
+    // d(sqrt(1-f_x^2))/d(f_x) = -f_x / sqrt(1-f_x^2)
+
+    auto step0 = this->invert();
+    auto step1 = step0->mul(f_x);
+    auto step2 = step1->negate();
+
+    Erase(step0);
+    Erase(step1);
+
+    return step2;
+}
+
+Expr const* Add::partial(int) const
+{
+    // d(f_1+...+f_n)/d(f_i) = 1
+
+    return constant(1);
+}
+
+Expr const* Mul::partial(int n) const
+{
+    // d(f_1*...*f_n)/d(f_i) = f_1*...*f_(i-1)*f_(i+1)*...*f_n
+
+    Terms step0(terms.begin(), terms.end());
+    step0.erase(step0.begin() + n);
+    return product(step0);
+}
+
+Expr const* Pow::partial(int n) const
+{
+    // d(f_x^g_x)/d(f_x) = g_x*f_x^(g_x-1) , d(f_x^g_x)/d(g_x) = f_x^g_x*log(f_x)
+
+    static Expr const& neg1 = *constant(-1);
+
+    if (n == 0)
+    {
+        auto step0 = g_x->add(neg1);
+        auto step1 = f_x->pow(step0);
+        auto step2 = g_x->mul(step1);
+
+        Erase(step0);
+        Erase(step1);
+
+        return step2;
+    }
+    else
+    {
+        auto step0 = f_x->log();
+        auto step1 = this->mul(step0);
+
+        Erase(step0);
+
+        return step1;
+    }
+}
+
+/***********************************************************************************************************************
+*** value()
+***********************************************************************************************************************/
+
+double Mul::value() const
+{
+    // NOTE: All of '0*inf', '0*nan', 'inf*0', 'nan*0' deliberately evaluate as '0'
+    // The purpose is to be able to prune [possibly undefined] branches of the expression tree by using a variable
+    // and giving it a value '1' (=use the multiplicand) or '0' (=prune the expression contained by multiplicand)
+
+    double x = 1;
+
+    for (auto p : terms)
+    {
+        auto y = p->evaluate();
+        if (y == 0) return 0;
+        x *= y;
+    }
+
+    return x;
+}
+
+/***********************************************************************************************************************
+*** attribute()
+***********************************************************************************************************************/
+
+/*
+bool <generic>::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::UNITRANGE:
+    case Attr::ANTIUNITRANGE:
+    case Attr::OPENUNITRANGE:
+    case Attr::ANTIOPENUNITRANGE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        ;
+    }
+
+    return false;
+}
+*/
+
+bool ConstantNode::attribute(Attr a) const
+{
+    if (!isnan(n) && !isinf(n)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::CONTINUOUS:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::NONZERO:
+        return n != 0;
+
+    case Attr::POSITIVE:
+        return n > 0;
+
+    case Attr::NEGATIVE:
+        return n < 0;
+
+    case Attr::NONPOSITIVE:
+        return n <= 0;
+
+    case Attr::NONNEGATIVE:
+        return n >= 0;
+
+    case Attr::UNITRANGE:
+        return n >= -1 && n <= 1;
+
+    case Attr::ANTIUNITRANGE:
+        return n < -1 || n > 1;
+
+    case Attr::OPENUNITRANGE:
+        return n > -1 && n < 1;
+
+    case Attr::ANTIOPENUNITRANGE:
+        return n <= -1 || n >= 1;
+    }
+
+    return false;
+}
+
+bool VariableNode::attribute(Attr a) const
+{
+    switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::NONDECREASING:
+        return true;
+    }
+
+    return false;
+}
+
+bool Abs::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONNEGATIVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::UNITRANGE:
+    case Attr::ANTIUNITRANGE:
+    case Attr::OPENUNITRANGE:
+    case Attr::ANTIOPENUNITRANGE:
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(a);
+
+    case Attr::POSITIVE:
+        return f_x->guaranteed(Attr::NONZERO);
+
+    case Attr::INCREASING:
+        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
+        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
+        return false;
+
+    case Attr::DECREASING:
+        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
+        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
+        return false;
+
+    case Attr::NONINCREASING:
+        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
+        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
+        return false;
+
+    case Attr::NONDECREASING:
+        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
+        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
+        return false;
+
+    case Attr::BOUNDEDABOVE:
+        return f_x->guaranteed(Attr::BOUNDEDABOVE) && f_x->guaranteed(Attr::BOUNDEDBELOW);
+    }
+
+    return false;
+}
+
+bool Sgn::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::UNITRANGE:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+        return f_x->guaranteed(a);
+
+    case Attr::ANTIOPENUNITRANGE:
+        return f_x->guaranteed(Attr::NONZERO);
+
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE);
+
+    case Attr::NONINCREASING:
+        return f_x->guaranteed(Attr::NONINCREASING) || f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE);
+
+    case Attr::NONDECREASING:
+        return f_x->guaranteed(Attr::NONDECREASING) || f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE);
+    }
+
+    return false;
+}
+
+bool Sqrt::attribute(Attr a) const
 {
     if (f_x->guaranteed(Attr::NONNEGATIVE)) switch (a)
     {
-    case Attr::DEFINED:
-    case Attr::NONNEGATIVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+    case Attr::DEFINED:
+    case Attr::NONNEGATIVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::UNITRANGE:
+    case Attr::ANTIUNITRANGE:
+    case Attr::OPENUNITRANGE:
+    case Attr::ANTIOPENUNITRANGE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool Cbrt::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::UNITRANGE:
+    case Attr::ANTIUNITRANGE:
+    case Attr::OPENUNITRANGE:
+    case Attr::ANTIOPENUNITRANGE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool Exp::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+        return f_x->guaranteed(a);
+
+    case Attr::UNITRANGE:
+        return f_x->guaranteed(Attr::NONPOSITIVE);
+
+    case Attr::ANTIUNITRANGE:
+        return f_x->guaranteed(Attr::POSITIVE);
+
+    case Attr::OPENUNITRANGE:
+        return f_x->guaranteed(Attr::NEGATIVE);
+
+    case Attr::ANTIOPENUNITRANGE:
+        return f_x->guaranteed(Attr::NONNEGATIVE);
+    }
+
+    return false;
+}
+
+bool ExpM1::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+        return f_x->guaranteed(a);
+
+    case Attr::UNITRANGE:
+    case Attr::OPENUNITRANGE:
+        return f_x->guaranteed(Attr::NONPOSITIVE);
+    }
+
+    return false;
+}
+
+bool Log::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::POSITIVE)) switch (a)
+    {
+    case Attr::DEFINED:
+        return true;
+
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+        return f_x->guaranteed(a);
+
+    case Attr::NONZERO:
+        return f_x->guaranteed(Attr::ANTIUNITRANGE) || f_x->guaranteed(Attr::OPENUNITRANGE);
+
+    case Attr::POSITIVE:
+        return f_x->guaranteed(Attr::ANTIUNITRANGE);
+
+    case Attr::NEGATIVE:
+        return f_x->guaranteed(Attr::OPENUNITRANGE);
+
+    case Attr::NONPOSITIVE:
+        return f_x->guaranteed(Attr::UNITRANGE);
+
+    case Attr::NONNEGATIVE:
+        return f_x->guaranteed(Attr::ANTIOPENUNITRANGE);
+    }
+
+    return false;
+}
+
+bool Log1P::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::OPENUNITRANGE) || f_x->guaranteed(Attr::POSITIVE)) switch (a)
+    {
+    case Attr::DEFINED:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool Sin::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::UNITRANGE:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool Cos::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::UNITRANGE:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool Tan::attribute(Attr a) const
+{
+    return false;
+}
+
+bool Sec::attribute(Attr a) const
+{
+    return false;
+}
+
+bool ASin::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::UNITRANGE)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool ACos::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::UNITRANGE)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONNEGATIVE:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(a);
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+        return f_x->guaranteed(Attr::OPENUNITRANGE);
+
+    case Attr::NONPOSITIVE:
+        return f_x->guaranteed(Attr::POSITIVE) && f_x->guaranteed(Attr::ANTIOPENUNITRANGE);
+
+    case Attr::INCREASING:
+        return f_x->guaranteed(Attr::DECREASING);
+
+    case Attr::DECREASING:
+        return f_x->guaranteed(Attr::INCREASING);
+
+    case Attr::NONINCREASING:
+        return f_x->guaranteed(Attr::NONDECREASING);
+
+    case Attr::NONDECREASING:
+        return f_x->guaranteed(Attr::NONINCREASING);
+    }
+
+    return false;
+}
+
+bool ATan::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool SinH::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool CosH::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::ANTIOPENUNITRANGE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(a);
+
+    case Attr::ANTIUNITRANGE:
+        return f_x->guaranteed(Attr::NONZERO);
+
+    case Attr::INCREASING:
+        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
+        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
+        return false;
+
+    case Attr::DECREASING:
+        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
+        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
+        return false;
+
+    case Attr::NONINCREASING:
+        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
+        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
+        return false;
+
+    case Attr::NONDECREASING:
+        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
+        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
+        return false;
+
+    case Attr::BOUNDEDABOVE:
+        return f_x->guaranteed(Attr::BOUNDEDABOVE) && f_x->guaranteed(Attr::BOUNDEDBELOW);
+    }
+
+    return false;
+}
+
+bool TanH::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::UNITRANGE:
+    case Attr::OPENUNITRANGE:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool SecH::attribute(Attr a) const
+{
+    return false;
+}
+
+bool ASinH::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool ACosH::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::POSITIVE) && f_x->guaranteed(Attr::ANTIOPENUNITRANGE)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONNEGATIVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+        return f_x->guaranteed(a);
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+        return f_x->guaranteed(Attr::ANTIUNITRANGE);
+    }
+
+    return false;
+}
+
+bool ATanH::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::OPENUNITRANGE)) switch (a)
+    {
+    case Attr::DEFINED:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool Erf::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::UNITRANGE:
+    case Attr::OPENUNITRANGE:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool ErfC::attribute(Attr a) const
+{
+    return false;
+}
+
+bool Invert::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::NONZERO)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONZERO:
+        return true;
+
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+        return f_x->guaranteed(a);
+
+    case Attr::UNITRANGE:
+        return f_x->guaranteed(Attr::ANTIOPENUNITRANGE);
+
+    case Attr::ANTIUNITRANGE:
+        return f_x->guaranteed(Attr::OPENUNITRANGE);
+
+    case Attr::OPENUNITRANGE:
+        return f_x->guaranteed(Attr::ANTIUNITRANGE);
+
+    case Attr::ANTIOPENUNITRANGE:
+        return f_x->guaranteed(Attr::UNITRANGE);
+
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE);
+
+    case Attr::INCREASING:
+        return f_x->guaranteed(Attr::DECREASING) && (f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE));
+
+    case Attr::DECREASING:
+        return f_x->guaranteed(Attr::INCREASING) && (f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE));
+
+    case Attr::NONINCREASING:
+        return f_x->guaranteed(Attr::NONDECREASING) && (f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE));
+
+    case Attr::NONDECREASING:
+        return f_x->guaranteed(Attr::NONINCREASING) && (f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE));
+    }
+
+    return false;
+}
+
+bool Negate::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::UNITRANGE:
+    case Attr::ANTIUNITRANGE:
+    case Attr::OPENUNITRANGE:
+    case Attr::ANTIOPENUNITRANGE:
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(a);
+
+    case Attr::POSITIVE:
+        return f_x->guaranteed(Attr::NEGATIVE);
+
+    case Attr::NEGATIVE:
+        return f_x->guaranteed(Attr::POSITIVE);
+
+    case Attr::NONPOSITIVE:
+        return f_x->guaranteed(Attr::NONNEGATIVE);
+
+    case Attr::NONNEGATIVE:
+        return f_x->guaranteed(Attr::NONPOSITIVE);
+
+    case Attr::INCREASING:
+        return f_x->guaranteed(Attr::DECREASING);
+
+    case Attr::DECREASING:
+        return f_x->guaranteed(Attr::INCREASING);
+
+    case Attr::NONINCREASING:
+        return f_x->guaranteed(Attr::NONDECREASING);
+
+    case Attr::NONDECREASING:
+        return f_x->guaranteed(Attr::NONINCREASING);
+
+    case Attr::BOUNDEDABOVE:
+        return f_x->guaranteed(Attr::BOUNDEDBELOW);
+
+    case Attr::BOUNDEDBELOW:
+        return f_x->guaranteed(Attr::BOUNDEDABOVE);
+    }
+
+    return false;
+}
+
+bool SoftPP::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::UNITRANGE:
+    case Attr::ANTIUNITRANGE:
+    case Attr::OPENUNITRANGE:
+    case Attr::ANTIOPENUNITRANGE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        ;
+    }
+
+    return false;
+}
+
+bool Spence::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::UNITRANGE) || f_x->guaranteed(Attr::NEGATIVE)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::BOUNDEDABOVE:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NEGATIVE:
+    case Attr::NONPOSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDBELOW:
+        return f_x->guaranteed(a);
+    }
+
+    return false;
+}
+
+bool Square::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONNEGATIVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::NONZERO:
+    case Attr::UNITRANGE:
+    case Attr::ANTIUNITRANGE:
+    case Attr::OPENUNITRANGE:
+    case Attr::ANTIOPENUNITRANGE:
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(a);
+
+    case Attr::POSITIVE:
+        return f_x->guaranteed(Attr::NONZERO);
+
+    case Attr::INCREASING:
+        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
+        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
+        return false;
+
+    case Attr::DECREASING:
+        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
+        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
+        return false;
+
+    case Attr::NONINCREASING:
+        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
+        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
+        return false;
+
+    case Attr::NONDECREASING:
+        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
+        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
+        return false;
+
+    case Attr::BOUNDEDABOVE:
+        return f_x->guaranteed(Attr::BOUNDEDABOVE) && f_x->guaranteed(Attr::BOUNDEDBELOW);
+    }
+
+    return false;
+}
+
+bool XConic::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::POSITIVE) && f_x->guaranteed(Attr::ANTIOPENUNITRANGE)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONNEGATIVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::CONTINUOUS:
+    case Attr::INCREASING:
+    case Attr::DECREASING:
+    case Attr::NONINCREASING:
+    case Attr::NONDECREASING:
+    case Attr::BOUNDEDABOVE:
+        return f_x->guaranteed(a);
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+        return f_x->guaranteed(Attr::ANTIUNITRANGE);
+    }
+
+    return false;
+}
+
+bool YConic::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NONNEGATIVE:
+    case Attr::ANTIOPENUNITRANGE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(a);
+
+    case Attr::ANTIUNITRANGE:
+        return f_x->guaranteed(Attr::NONZERO);
+
+    case Attr::INCREASING:
+        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
+        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
+        return false;
+
+    case Attr::DECREASING:
+        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
+        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
+        return false;
+
+    case Attr::NONINCREASING:
+        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
+        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
+        return false;
+
+    case Attr::NONDECREASING:
+        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
+        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
+        return false;
+
+    case Attr::BOUNDEDABOVE:
+        return f_x->guaranteed(Attr::BOUNDEDABOVE) && f_x->guaranteed(Attr::BOUNDEDBELOW);
+    }
+
+    return false;
+}
+
+bool ZConic::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::UNITRANGE)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONNEGATIVE:
+    case Attr::UNITRANGE:
+    case Attr::BOUNDEDABOVE:
+    case Attr::BOUNDEDBELOW:
+        return true;
+
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(a);
+
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+        return f_x->guaranteed(Attr::OPENUNITRANGE);
+
+    case Attr::NONPOSITIVE:
+        return f_x->guaranteed(Attr::ANTIOPENUNITRANGE);
+
+    case Attr::OPENUNITRANGE:
+        return f_x->guaranteed(Attr::NONZERO);
+
+    case Attr::INCREASING:
+        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
+        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
+        return false;
+
+    case Attr::DECREASING:
+        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
+        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
+        return false;
+
+    case Attr::NONINCREASING:
+        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
+        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
+        return false;
+
+    case Attr::NONDECREASING:
+        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
+        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
+        return false;
+    }
+
+    return false;
+}
+
+bool Add::attribute(Attr a) const
+{
+    auto const all = [&](Attr b) { for (auto p : terms) if (!p->guaranteed(b)) return false; return true; };
+    auto const any = [&](Attr b) { for (auto p : terms) if (p->guaranteed(b)) return true; return false; };
+
+    if (all(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+        return true;
+
+    case Attr::NONZERO:
+        if (all(Attr::NONNEGATIVE) && any(Attr::POSITIVE)) return true;
+        if (all(Attr::NONPOSITIVE) && any(Attr::NEGATIVE)) return true;
+        return false;
+
+    case Attr::POSITIVE:
+        return all(Attr::NONNEGATIVE) && any(Attr::POSITIVE);
+
+    case Attr::NEGATIVE:
+        return all(Attr::NONPOSITIVE) && any(Attr::NEGATIVE);
+
+    case Attr::NONPOSITIVE:
+        return all(a);
+
+    case Attr::NONNEGATIVE:
+        return all(a);
+
+    case Attr::UNITRANGE:
+        break;
+
+    case Attr::ANTIUNITRANGE:
+        break;
+
+    case Attr::OPENUNITRANGE:
+        break;
+
+    case Attr::ANTIOPENUNITRANGE:
+        break;
+
+    case Attr::CONTINUOUS:
+        return all(a);
+
+    case Attr::INCREASING:
+        return all(Attr::NONDECREASING) && any(Attr::INCREASING);
+
+    case Attr::DECREASING:
+        return all(Attr::NONINCREASING) && any(Attr::DECREASING);
+
+    case Attr::NONINCREASING:
+        return all(a);
+
+    case Attr::NONDECREASING:
+        return all(a);
+
+    case Attr::BOUNDEDABOVE:
+        return all(a);
+
+    case Attr::BOUNDEDBELOW:
+        return all(a);
+    }
+
+    return false;
+}
+
+bool Mul::attribute(Attr a) const
+{
+    auto const all = [&](Attr b) { for (auto p : terms) if (!p->guaranteed(b)) return false; return true; };
+
+    auto const negatives = [&]()  // Number of negative terms when every term is either positive or negative, else -1
+    {
+        int n = 0;
+
+        for (auto p : terms)
+        {
+            if (p->guaranteed(Attr::NEGATIVE)) ++n;
+            else if (!p->guaranteed(Attr::POSITIVE)) return -1;
+        }
+
+        return n;
+    };
+
+    if (all(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+        return true;
+
+    case Attr::NONZERO:
+        return all(a);
+
+    case Attr::POSITIVE:
+        return negatives() % 2 == 0;
+
+    case Attr::NEGATIVE:
+        return negatives() % 2 == 1;
+
+    case Attr::NONPOSITIVE:
+        break;
+
+    case Attr::NONNEGATIVE:
+        break;
+
+    case Attr::UNITRANGE:
+        return all(a);
+
+    case Attr::ANTIUNITRANGE:
+        return all(a);
+
+    case Attr::OPENUNITRANGE:
+        return all(a);
+
+    case Attr::ANTIOPENUNITRANGE:
+        return all(a);
+
+    case Attr::CONTINUOUS:
+        return all(a);
+
+    case Attr::INCREASING:
+        break;
+
+    case Attr::DECREASING:
+        break;
+
+    case Attr::NONINCREASING:
+        break;
+
+    case Attr::NONDECREASING:
+        break;
+
+    case Attr::BOUNDEDABOVE:
+        break;
+
+    case Attr::BOUNDEDBELOW:
+        break;
+    }
+
+    return false;
+}
+
+bool Pow::attribute(Attr a) const
+{
+    if (f_x->guaranteed(Attr::POSITIVE) && g_x->guaranteed(Attr::DEFINED)) switch (a)
+    {
+    case Attr::DEFINED:
+    case Attr::NONZERO:
+    case Attr::POSITIVE:
+    case Attr::NONNEGATIVE:
+        return true;
+
+    case Attr::UNITRANGE:
+        break;
+
+    case Attr::ANTIUNITRANGE:
+        break;
+
+    case Attr::OPENUNITRANGE:
+        break;
+
+    case Attr::ANTIOPENUNITRANGE:
+        break;
+
+    case Attr::CONTINUOUS:
+        return f_x->guaranteed(a) && g_x->guaranteed(a);
+
+    case Attr::INCREASING:
+        break;
+
+    case Attr::DECREASING:
+        break;
+
+    case Attr::NONINCREASING:
+        break;
+
+    case Attr::NONDECREASING:
+        break;
+
+    case Attr::BOUNDEDABOVE:
+        break;
+
+    case Attr::BOUNDEDBELOW:
+        break;
+    }
+
+    return false;
+}
+
+/***********************************************************************************************************************
+*** interval()
+***********************************************************************************************************************/
+
+static FORCEINLINE double compute(Expr::NodeType, double, double);  // See 'CompiledExpression::data'
+
+template <typename F> static Expr::Interval periodic(F f, double lo, double hi, double phase)
+{
+    // Between the points 'phase+k*pi' the function is monotonic, and at them it is at its maximum 1 for an even 'k' and
+    // at its minimum -1 for an odd one
+
+    auto const pi = std::acos(-1.0);
+
+    if (!(hi - lo < 2 * pi)) return { -1, 1 };
+
+    Expr::Interval r{ std::min(f(lo), f(hi)), std::max(f(lo), f(hi)) };
+
+    for (auto k = std::ceil((lo - phase) / pi); phase + k * pi <= hi; ++k)
+    {
+        if (std::fmod(k, 2) == 0) r.hi = 1; else r.lo = -1;
+    }
+
+    return r;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Expr::Interval FunctionNode::interval() const
+{
+    // Apart from the periodic ones each function is monotonic on its domain, or on either side of zero where it is even
+    // and then computed at the ends of the range of '|x|'.  NOTE: The ends are computed by the same functions as the
+    // values, so the bounds hold for the computed values without having to be widened by their rounding.
+
+    auto const r = f_x->range();
+    auto const f = [this](double x) { return compute(fn, x, 0); };
+    auto const up = [&f](double lo, double hi) { return Interval{ f(lo), f(hi) }; };
+    auto const down = [&f](double lo, double hi) { return Interval{ f(hi), f(lo) }; };
+
+    auto const small = r.lo > 0 ? r.lo : r.hi < 0 ? -r.hi : 0;  // Range of '|x|'
+    auto const large = std::max(-r.lo, r.hi);
+    auto const pi = std::acos(-1.0);
+
+    switch (fn)
+    {
+    case NodeType::SGN:
+    case NodeType::CBRT:
+    case NodeType::EXP:
+    case NodeType::EXPM1:
+    case NodeType::ATAN:
+    case NodeType::SINH:
+    case NodeType::TANH:
+    case NodeType::ASINH:
+    case NodeType::ERF:
+    case NodeType::SOFTPP:
+        return up(r.lo, r.hi);
+
+    case NodeType::SQRT:
+    case NodeType::LOG:
+        return up(std::max(r.lo, 0.0), r.hi);
+
+    case NodeType::LOG1P:
+        return up(std::max(r.lo, -1.0), r.hi);
+
+    case NodeType::ASIN:
+    case NodeType::ATANH:
+        return up(std::max(r.lo, -1.0), std::min(r.hi, 1.0));
+
+    case NodeType::ACOSH:
+        return up(std::max(r.lo, 1.0), r.hi);
+
+    case NodeType::SPENCE:
+        return up(r.lo, std::min(r.hi, 1.0));
+
+    case NodeType::ACOS:
+        return down(std::max(r.lo, -1.0), std::min(r.hi, 1.0));
+
+    case NodeType::ERFC:
+    case NodeType::NEGATE:
+        return down(r.lo, r.hi);
+
+    case NodeType::ABS:
+    case NodeType::SQUARE:
+    case NodeType::COSH:
+    case NodeType::YCONIC:
+        return up(small, large);
+
+    case NodeType::XCONIC:
+        return up(std::max(small, 1.0), large);
+
+    case NodeType::SECH:
+        return down(small, large);
+
+    case NodeType::ZCONIC:
+        return down(small, std::min(large, 1.0));
+
+    case NodeType::INVERT:
+        if (r.lo > 0 || r.hi < 0) return down(r.lo, r.hi);
+        break;
+
+    case NodeType::SIN:
+        return periodic(f, r.lo, r.hi, pi / 2);
+
+    case NodeType::COS:
+        return periodic(f, r.lo, r.hi, 0);
+
+    case NodeType::TAN:
+        if (r.hi - r.lo < pi && std::floor(r.lo / pi - 0.5) == std::floor(r.hi / pi - 0.5)) return up(r.lo, r.hi);  // No pole within
+        break;
+
+    case NodeType::SEC:
+        {
+            auto const c = periodic([](double x) { return std::cos(x); }, r.lo, r.hi, 0);
+            if (c.lo > 0 || c.hi < 0) return { 1 / c.hi, 1 / c.lo };
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return { -HUGE_VAL, HUGE_VAL };
+}
+
+Expr::Interval Add::interval() const
+{
+    Interval r{ 0, 0 };
+
+    for (auto p : terms)
+    {
+        auto const s = p->range();
+        r.lo += s.lo;
+        r.hi += s.hi;
+    }
+
+    return r;
+}
+
+Expr::Interval Mul::interval() const
+{
+    // The extremes of a product are among those of the ends of its factors, multiplied as in 'Mul::value()'
+
+    Interval r{ 1, 1 };
+
+    for (auto p : terms)
+    {
+        auto const s = p->range();
+        double const x[] = { compute(NodeType::MUL, r.lo, s.lo), compute(NodeType::MUL, r.lo, s.hi), compute(NodeType::MUL, r.hi, s.lo), compute(NodeType::MUL, r.hi, s.hi) };
+        r = { *std::min_element(x, x + 4), *std::max_element(x, x + 4) };
+    }
+
+    return r;
+}
+
+Expr::Interval Pow::interval() const
+{
+    // With a nonnegative base 'pow()' is monotonic in either operand, so its extremes are at the corners.  A negative
+    // base is only defined with an integer exponent, of which a constant positive one is handled like 'square()'.
+
+    auto const r = f_x->range();
+    auto const s = g_x->range();
+
+    if (r.lo < 0 && (s.lo != s.hi || s.lo == std::floor(s.lo)))
+    {
+        if (s.lo != s.hi || s.lo <= 0) return { -HUGE_VAL, HUGE_VAL };
+        if (std::fmod(s.lo, 2) != 0) return { std::pow(r.lo, s.lo), std::pow(r.hi, s.lo) };
+
+        auto const small = r.hi < 0 ? -r.hi : 0;
+        return { std::pow(small, s.lo), std::pow(std::max(-r.lo, r.hi), s.lo) };
+    }
+
+    auto const lo = std::max(r.lo, 0.0);
+    double const x[] = { std::pow(lo, s.lo), std::pow(lo, s.hi), std::pow(r.hi, s.lo), std::pow(r.hi, s.hi) };
+    return { *std::min_element(x, x + 4), *std::max_element(x, x + 4) };
+}
+
+/***********************************************************************************************************************
+*** print()
+***********************************************************************************************************************/
+
+void ConstantNode::print(std::ostream& out, std::vector<Token>&) const
+{
+    out << n;
+}
+
+void VariableNode::print(std::ostream& out, std::vector<Token>&) const
+{
+    out << x.Name();
+}
+
+void Abs::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "abs(", f_x, ")" });
+}
+
+void Sgn::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "sgn(", f_x, ")" });
+}
+
+void Sqrt::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "sqrt(", f_x, ")" });
+}
+
+void Cbrt::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "cbrt(", f_x, ")" });
+}
+
+void Exp::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "exp(", f_x, ")" });
+}
+
+void ExpM1::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "expm1(", f_x, ")" });
+}
+
+void Log::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "log(", f_x, ")" });
+}
+
+void Log1P::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "log1p(", f_x, ")" });
+}
+
+void Sin::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "sin(", f_x, ")" });
+}
+
+void Cos::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "cos(", f_x, ")" });
+}
+
+void Tan::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "tan(", f_x, ")" });
+}
+
+void Sec::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "sec(", f_x, ")" });
+}
+
+void ASin::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "asin(", f_x, ")" });
+}
+
+void ACos::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "acos(", f_x, ")" });
+}
+
+void ATan::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "atan(", f_x, ")" });
+}
+
+void SinH::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "sinh(", f_x, ")" });
+}
+
+void CosH::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "cosh(", f_x, ")" });
+}
+
+void TanH::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "tanh(", f_x, ")" });
+}
+
+void SecH::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "sech(", f_x, ")" });
+}
+
+void ASinH::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "asinh(", f_x, ")" });
+}
+
+void ACosH::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "acosh(", f_x, ")" });
+}
+
+void ATanH::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "atanh(", f_x, ")" });
+}
+
+void Erf::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "erf(", f_x, ")" });
+}
+
+void ErfC::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "erfc(", f_x, ")" });
+}
+
+void Invert::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "1/(", f_x, ")" });
+}
+
+void Negate::print(std::ostream& out, std::vector<Token>& r) const
+{
+    out << "-";
+    if (f_x->is(NodeType::ADD)) r.insert(r.end(), { "(", f_x, ")" });
+    else r.push_back(f_x);
+}
+
+void SoftPP::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "softpp(", f_x, ")" });
+}
+
+void Spence::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "Li2(", f_x, ")" });
+}
+
+void Square::print(std::ostream&, std::vector<Token>& r) const
+{
+    if (f_x->is(NodeType::ADD) || f_x->is(NodeType::MUL)) r.insert(r.end(), { "(", f_x, ")^2" });
+    else r.insert(r.end(), { f_x, "^2" });
+}
+
+void XConic::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "xconic(", f_x, ")" });
+}
+
+void YConic::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "yconic(", f_x, ")" });
+}
+
+void ZConic::print(std::ostream&, std::vector<Token>& r) const
+{
+    r.insert(r.end(), { "zconic(", f_x, ")" });
+}
+
+void Add::print(std::ostream&, std::vector<Token>& r) const
+{
+    for (size_t i = 0; i < terms.size(); ++i)
+    {
+        if (i) r.push_back("+");
+        r.push_back(terms[i]);
+    }
+}
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::UNITRANGE:
-    case Attr::ANTIUNITRANGE:
-    case Attr::OPENUNITRANGE:
-    case Attr::ANTIOPENUNITRANGE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(a);
+void Mul::print(std::ostream&, std::vector<Token>& r) const
+{
+    for (size_t i = 0; i < terms.size(); ++i)
+    {
+        if (i) r.push_back("*");
+        if (terms[i]->is(NodeType::ADD) || terms[i]->is(NodeType::POW)) r.insert(r.end(), { "(", terms[i], ")" });
+        else r.push_back(terms[i]);
     }
+}
+
+void Pow::print(std::ostream&, std::vector<Token>& r) const
+{
+    if (f_x->is(NodeType::ADD) || f_x->is(NodeType::MUL) || f_x->is(NodeType::POW)) r.insert(r.end(), { "(", f_x, ")" });
+    else r.push_back(f_x);
+    r.push_back("^");
+    if (g_x->is(NodeType::ADD) || g_x->is(NodeType::MUL) || g_x->is(NodeType::POW)) r.insert(r.end(), { "(", g_x, ")" });
+    else r.push_back(g_x);
+}
+
+/***********************************************************************************************************************
+*** topological()
+***********************************************************************************************************************/
+
+static std::vector<Expr const*> topological(std::vector<Expr const*> const& roots)
+{
+    // Sort the DAG topologically (operands before the nodes using them).  Every shared node is listed exactly once.
+
+    std::vector<Expr const*> order;
+    std::unordered_set<Expr const*> visited;
+
+    for (auto root : roots) postorder(root, [&visited](Expr const* p) { return !visited.insert(p).second; }, [&order](Expr const* p) { order.push_back(p); });
+
+    return order;
+}
+
+static std::vector<Expr const*> topological(Expr const* root)
+{
+    return topological(std::vector<Expr const*>{ root });
+}
+
+/***********************************************************************************************************************
+*** Expression
+***********************************************************************************************************************/
+
+Expression::Expression() : pData(Shared::Clone(Nan::instance))
+{
+}
+
+Expression::Expression(Expression const& r) : pData(Shared::Clone(r.pData))
+{
+}
+
+Expression::Expression(Variable const& r) : pData(data::variable(r))
+{
+}
+
+Expression::Expression(double d) : pData(data::constant(d))
+{
+}
+
+Expression::Expression(int i) : pData(data::constant(i))
+{
+}
+
+Expression::Expression(data const* p) : pData(p)
+{
+}
+
+Expression::~Expression()
+{
+    Shared::Erase(pData);
+}
+
+Expression& Expression::operator=(Expression const& r) noexcept
+{
+    Shared::Clone(r.pData);
+    Shared::Erase(pData);
+    pData = r.pData;
+    return *this;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Expression abs(Expression const& r)
+{
+    return r.pData->abs();
+}
+
+Expression sgn(Expression const& r)
+{
+    return r.pData->sgn();
+}
+
+Expression sqrt(Expression const& r)
+{
+    return r.pData->sqrt();
+}
+
+Expression cbrt(Expression const& r)
+{
+    return r.pData->cbrt();
+}
+
+Expression exp(Expression const& r)
+{
+    return r.pData->exp();
+}
+
+Expression expm1(Expression const& r)
+{
+    return r.pData->expm1();
+}
+
+Expression log(Expression const& r)
+{
+    return r.pData->log();
+}
+
+Expression log1p(Expression const& r)
+{
+    return r.pData->log1p();
+}
+
+Expression sin(Expression const& r)
+{
+    return r.pData->sin();
+}
+
+Expression cos(Expression const& r)
+{
+    return r.pData->cos();
+}
+
+Expression tan(Expression const& r)
+{
+    return r.pData->tan();
+}
+
+Expression asin(Expression const& r)
+{
+    return r.pData->asin();
+}
+
+Expression acos(Expression const& r)
+{
+    return r.pData->acos();
+}
+
+Expression atan(Expression const& r)
+{
+    return r.pData->atan();
+}
+
+Expression sinh(Expression const& r)
+{
+    return r.pData->sinh();
+}
+
+Expression cosh(Expression const& r)
+{
+    return r.pData->cosh();
+}
+
+Expression tanh(Expression const& r)
+{
+    return r.pData->tanh();
+}
+
+Expression asinh(Expression const& r)
+{
+    return r.pData->asinh();
+}
+
+Expression acosh(Expression const& r)
+{
+    return r.pData->acosh();
+}
+
+Expression atanh(Expression const& r)
+{
+    return r.pData->atanh();
+}
+
+Expression erf(Expression const& r)
+{
+    return r.pData->erf();
+}
+
+Expression erfc(Expression const& r)
+{
+    return r.pData->erfc();
+}
+
+Expression Li2(Expression const& r)
+{
+    return r.pData->spence();
+}
+
+Expression Spp(Expression const& r)
+{
+    return r.pData->softpp();
+}
+
+Expression operator+(Expression const& r)
+{
+    return r;
+}
 
-    return false;
+Expression operator-(Expression const& r)
+{
+    return r.pData->negate();
 }
 
-bool Cbrt::guaranteed(Attr a) const
+Expression operator+(Expression const& r, Expression const& s)
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-        return true;
+    return r.pData->add(s.pData);
+}
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::UNITRANGE:
-    case Attr::ANTIUNITRANGE:
-    case Attr::OPENUNITRANGE:
-    case Attr::ANTIOPENUNITRANGE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return f_x->guaranteed(a);
-    }
+Expression operator-(Expression const& r, Expression const& s)
+{
+    // f_x-g_x = f_x + -g_x
 
-    return false;
+    auto step0 = s.pData->negate();
+    auto step1 = r.pData->add(step0);
+
+    Shared::Erase(step0);
+
+    return step1;
 }
 
-bool Exp::guaranteed(Attr a) const
+Expression operator*(Expression const& r, Expression const& s)
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+    return r.pData->mul(s.pData);
+}
 
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(a);
+Expression operator/(Expression const& r, Expression const& s)
+{
+    // f_x/g_x = f_x * 1/g_x
 
-    case Attr::UNITRANGE:
-        return f_x->guaranteed(Attr::NONPOSITIVE);
+    auto step0 = s.pData->invert();
+    auto step1 = r.pData->mul(step0);
 
-    case Attr::ANTIUNITRANGE:
-        return f_x->guaranteed(Attr::POSITIVE);
+    Shared::Erase(step0);
 
-    case Attr::OPENUNITRANGE:
-        return f_x->guaranteed(Attr::NEGATIVE);
+    return step1;
+}
 
-    case Attr::ANTIOPENUNITRANGE:
-        return f_x->guaranteed(Attr::NONNEGATIVE);
-    }
+double Expression::operator()() const noexcept
+{
+    return pData->evaluate();
+}
 
-    return false;
+Expression::operator double() const
+{
+    return pData->evaluate();
 }
 
-bool ExpM1::guaranteed(Attr a) const
+Expression pow(Expression const& r, Expression const& s)
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::BOUNDEDBELOW:
-        return true;
+    return r.pData->pow(s.pData);
+}
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(a);
+Expression Sum(std::vector<Expression> r)
+{
+    // Pairwise summation: the partial sums are flattened into n-ary sums of up to 'MAXTERMS' terms, so that the result
+    // is a balanced tree of those rather than a chain of depth N
 
-    case Attr::UNITRANGE:
-    case Attr::OPENUNITRANGE:
-        return f_x->guaranteed(Attr::NONPOSITIVE);
+    if (r.empty()) return 0;
+
+    for (size_t n = 1; n < r.size(); n *= 2)
+    {
+        for (size_t i = 0; i + n < r.size(); i += 2 * n) r[i] = r[i] + r[i + n];
     }
 
-    return false;
+    return r[0];
 }
 
-bool Log::guaranteed(Attr a) const
+Expression Mean(std::vector<Expression> const& r)
 {
-    if (f_x->guaranteed(Attr::POSITIVE)) switch (a)
-    {
-    case Attr::DEFINED:
-        return true;
-
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(a);
+    return Sum(r) / double(r.size());
+}
 
-    case Attr::NONZERO:
-        return f_x->guaranteed(Attr::ANTIUNITRANGE) || f_x->guaranteed(Attr::OPENUNITRANGE);
+void AtomicAssign(Bindings& r)
+{
+    // Assigned over and over, the same bindings are better made an 'ExpressionGroup' once, see 'AtomicAssign()' of it
 
-    case Attr::POSITIVE:
-        return f_x->guaranteed(Attr::ANTIUNITRANGE);
+    auto const N = r.size();
+    double* p = new double[N];
 
-    case Attr::NEGATIVE:
-        return f_x->guaranteed(Attr::OPENUNITRANGE);
+    for (size_t i = 0; i < N; ++i) p[i] = r[i].second();
+    for (size_t i = 0; i < N; ++i) r[i].first = p[i];
 
-    case Attr::NONPOSITIVE:
-        return f_x->guaranteed(Attr::UNITRANGE);
+    delete[] p;
+}
 
-    case Attr::NONNEGATIVE:
-        return f_x->guaranteed(Attr::ANTIOPENUNITRANGE);
-    }
+Expression Expression::AtomicBind(Bindings const& r) const
+{
+    Substitution t(r.size());
+    for (auto& s : r) t.emplace(s.first.id(), s.second.pData);  // Like before, the first binding of a variable wins
 
-    return false;
+    auto result = pData->bind(t);
+    pData->purge();
+    return result;
 }
 
-bool Log1P::guaranteed(Attr a) const
+Expression Expression::Bind(Variable const& r, double d) const
 {
-    if (f_x->guaranteed(Attr::OPENUNITRANGE) || f_x->guaranteed(Attr::POSITIVE)) switch (a)
-    {
-    case Attr::DEFINED:
-        return true;
-
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return f_x->guaranteed(a);
-    }
+    Expression s(d);
+    Substitution t{ { r.id(), s.pData } };
 
-    return false;
+    auto result = pData->bind(t);
+    pData->purge();
+    return result;
 }
 
-bool Sin::guaranteed(Attr a) const
+std::vector<Expression> Expression::BindMany(Variable const& r, std::vector<double> const& d) const
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::UNITRANGE:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+    // Same as 'Bind(r, d[i])' for each 'i' but the subgraphs that do not contain 'r' are visited once for all of the
+    // samples: their 'cached()' is primed to the node itself, so 'bind()' returns them without descending into them.
 
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a);
+    auto const order = topological(pData);
+
+    std::unordered_set<Expr const*> dependent;
+
+    for (auto p : order)
+    {
+        bool depends = p->is(data::NodeType::VARIABLE) && static_cast<VariableNode const*>(p)->x.id() == r.id();
+        for (int i = 0; auto q = p->operand(i); ++i) depends = depends || dependent.count(q);
+        if (depends) dependent.insert(p); else p->cached() = Shared::Clone(p);
     }
 
-    return false;
-}
+    std::vector<Expression> result;
 
-bool Cos::guaranteed(Attr a) const
-{
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    for (auto x : d)
     {
-    case Attr::DEFINED:
-    case Attr::UNITRANGE:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+        Expression s(x);
+        Substitution t{ { r.id(), s.pData } };
 
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a);
+        result.push_back(pData->bind(t));
+
+        for (auto p : dependent)
+        {
+            Shared::Erase(p->cached());
+            p->cached() = nullptr;
+        }
     }
 
-    return false;
-}
+    for (auto p : order)
+    {
+        Shared::Erase(p->cached());
+        p->cached() = nullptr;
+    }
 
-bool Tan::guaranteed(Attr a) const
-{
-    return false;
+    pData->purge();  // Of the emptied entries
+
+    return result;
 }
 
-bool Sec::guaranteed(Attr a) const
+Expression Expression::Derive(Variable const& r) const
 {
-    return false;
+    auto result = pData->derive(r);
+    pData->purge();
+    return result;
 }
 
-bool ASin::guaranteed(Attr a) const
+std::vector<Expression> Expression::Gradient(std::vector<Variable> const& r) const
 {
-    if (f_x->guaranteed(Attr::UNITRANGE)) switch (a)
+    // Reverse accumulation: the adjoint of each node is the sum over its users of the user's adjoint times the partial
+    // derivative of the user with respect to the node.  All adjoints are built in a single sweep over the DAG.
+
+    auto const order = topological(pData);
+
+    std::unordered_set<size_t> wanted;
+    std::unordered_set<Expr const*> relevant;
+    std::unordered_map<Expr const*, Expr const*> adjoint;
+
+    for (auto& v : r) wanted.insert(v.id());
+
+    for (auto p : order)  // Only the subgraphs that contain any of the wanted variables need to be visited
     {
-    case Attr::DEFINED:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+        bool depends = p->is(data::NodeType::VARIABLE) && wanted.count(static_cast<VariableNode const*>(p)->x.id());
+        for (int i = 0; auto q = p->operand(i); ++i) depends = depends || relevant.count(q);
+        if (depends) relevant.insert(p);
+    }
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-        return f_x->guaranteed(a);
+    if (!relevant.count(pData))  // None of the variables is contained (the derivatives are constants or 'nan')
+    {
+        std::vector<Expression> gradient;
+        for (auto& v : r) gradient.push_back(Derive(v));
+        return gradient;
     }
 
-    return false;
-}
+    adjoint[pData] = data::constant(1);
 
-bool ACos::guaranteed(Attr a) const
-{
-    if (f_x->guaranteed(Attr::UNITRANGE)) switch (a)
+    for (auto n = order.rbegin(); n != order.rend(); ++n)
     {
-    case Attr::DEFINED:
-    case Attr::NONNEGATIVE:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+        auto node = adjoint.find(*n);
+        if (node == adjoint.end()) continue;
 
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a);
+        auto const a = node->second;  // The entries of the operands may rehash the table
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-        return f_x->guaranteed(Attr::OPENUNITRANGE);
+        for (int i = 0; auto q = (*n)->operand(i); ++i) if (relevant.count(q))
+        {
+            auto step0 = (*n)->partial(i);
+            auto step1 = a->mul(step0);
 
-    case Attr::NONPOSITIVE:
-        return f_x->guaranteed(Attr::POSITIVE) && f_x->guaranteed(Attr::ANTIOPENUNITRANGE);
+            Shared::Erase(step0);
 
-    case Attr::INCREASING:
-        return f_x->guaranteed(Attr::DECREASING);
+            auto& sum = adjoint[q];
+
+            if (sum)
+            {
+                auto step2 = sum->add(step1);
+                Shared::Erase(sum);
+                Shared::Erase(step1);
+                sum = step2;
+            }
+            else
+            {
+                sum = step1;
+            }
+        }
+    }
 
-    case Attr::DECREASING:
-        return f_x->guaranteed(Attr::INCREASING);
+    std::unordered_map<size_t, Expr const*> result;
+    for (auto& item : adjoint) if (item.first->is(data::NodeType::VARIABLE)) result[static_cast<VariableNode const*>(item.first)->x.id()] = item.second;
 
-    case Attr::NONINCREASING:
-        return f_x->guaranteed(Attr::NONDECREASING);
+    std::vector<Expression> gradient;
+    for (auto& v : r) gradient.push_back(result.count(v.id()) ? Expression(Shared::Clone(result[v.id()])) : Expression(0));
 
-    case Attr::NONDECREASING:
-        return f_x->guaranteed(Attr::NONINCREASING);
-    }
+    for (auto& item : adjoint) Shared::Erase(item.second);
 
-    return false;
+    return gradient;
 }
 
-bool ATan::guaranteed(Attr a) const
+double Expression::Evaluate() const
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
-
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-        return f_x->guaranteed(a);
-    }
-
-    return false;
+    return pData->evaluate();
 }
 
-bool SinH::guaranteed(Attr a) const
+bool Expression::Guaranteed(Attribute a) const
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-        return true;
+    return pData->guaranteed(a);
+}
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return f_x->guaranteed(a);
-    }
+std::pair<double, double> Expression::Range() const
+{
+    auto r = pData->range();
+    return { r.lo, r.hi };
+}
 
-    return false;
+void Expression::Touch()
+{
+    Expr::touch(~uint64_t(0));
 }
 
-bool CosH::guaranteed(Attr a) const
+int32_t Expression::Depth() const noexcept
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::ANTIOPENUNITRANGE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+    return pData->depth;
+}
 
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a);
+std::ostream& operator<<(std::ostream& r, Expression const& s)
+{
+    s.pData->print(r);
+    return r;
+}
 
-    case Attr::ANTIUNITRANGE:
-        return f_x->guaranteed(Attr::NONZERO);
+/***********************************************************************************************************************
+*** Variable::data
+***********************************************************************************************************************/
 
-    case Attr::INCREASING:
-        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
-        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
-        return false;
+struct Variable::data : public Shared
+{
+    data(double d, double a, double b) : value(d), lo(a), hi(b), bit(uint64_t(1) << count++ % 64), name("[&" + std::to_string(size_t(this) / sizeof(*this)) + "]") { }
 
-    case Attr::DECREASING:
-        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
-        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
-        return false;
+    mutable double value;
+    double const lo;  // Declared range of the values, see 'Expression::data::range()'
+    double const hi;
+    uint64_t const bit;  // Variables created in sequence get different bits, see 'Expression::data::dependencies'
+    mutable std::string name;
 
-    case Attr::NONINCREASING:
-        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        return false;
+    static Counter<size_t> count;
+};
 
-    case Attr::NONDECREASING:
-        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        return false;
+//----------------------------------------------------------------------------------------------------------------------
 
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(Attr::BOUNDEDABOVE) && f_x->guaranteed(Attr::BOUNDEDBELOW);
-    }
+Counter<size_t> Variable::data::count;
 
-    return false;
+uint64_t Expression::data::dependency(Variable const& r)
+{
+    return reinterpret_cast<Variable::data const*>(r.id())->bit;  // NOTE: 'id()' is the address of the data
 }
 
-bool TanH::guaranteed(Attr a) const
+void Expression::data::touch(uint64_t m)
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::UNITRANGE:
-    case Attr::OPENUNITRANGE:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+    for (; m; m &= m - 1) ++touchLevel[lowestBit(m)];
+    ++dirtyLevel;
+}
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-        return f_x->guaranteed(a);
-    }
+/***********************************************************************************************************************
+*** Variable
+***********************************************************************************************************************/
 
-    return false;
+Variable::Variable(double d) : pData(new data(d, -HUGE_VAL, HUGE_VAL))
+{
 }
 
-bool SecH::guaranteed(Attr a) const
+Variable::Variable(double d, double lo, double hi) : pData(new data(d, lo, hi))
 {
-    return false;
+    assert(lo <= d && d <= hi);
 }
 
-bool ASinH::guaranteed(Attr a) const
+Variable::Variable(Variable const& r) noexcept : pData(Shared::Clone(r.pData))
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-        return true;
-
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return f_x->guaranteed(a);
-    }
+}
 
-    return false;
+Variable::~Variable() noexcept
+{
+    Shared::Erase(pData);
 }
 
-bool ACosH::guaranteed(Attr a) const
+Variable& Variable::operator=(double d)
 {
-    if (f_x->guaranteed(Attr::POSITIVE) && f_x->guaranteed(Attr::ANTIOPENUNITRANGE)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::NONNEGATIVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+    assert(!isinf(d));
+    assert(!isnan(d));
+    assert(pData->lo <= d && d <= pData->hi);  // The simplifications may have relied on the range
 
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(a);
+    pData->value = d;
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-        return f_x->guaranteed(Attr::ANTIUNITRANGE);
-    }
+    Expr::touch(pData->bit);
 
-    return false;
+    return *this;
 }
 
-bool ATanH::guaranteed(Attr a) const
+Variable::operator double() const noexcept
 {
-    if (f_x->guaranteed(Attr::OPENUNITRANGE)) switch (a)
-    {
-    case Attr::DEFINED:
-        return true;
-
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-        return f_x->guaranteed(a);
-    }
+    return pData->value;
+}
 
-    return false;
+double Variable::operator()() const noexcept
+{
+    return pData->value;
 }
 
-bool Erf::guaranteed(Attr a) const
+std::pair<double, double> Variable::Range() const
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::UNITRANGE:
-    case Attr::OPENUNITRANGE:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+    return { pData->lo, pData->hi };
+}
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-        return f_x->guaranteed(a);
-    }
+std::string Variable::Name() const
+{
+    return pData->name;
+}
 
-    return false;
+void Variable::Name(std::string const& s)
+{
+    pData->name = s;
 }
 
-bool ErfC::guaranteed(Attr a) const
+size_t Variable::id() const
 {
-    return false;
+    return size_t(pData);
 }
 
-bool Invert::guaranteed(Attr a) const
+/***********************************************************************************************************************
+*** CompiledExpression::data
+***********************************************************************************************************************/
+
+struct CompiledExpression::data : public Shared
 {
-    if (f_x->guaranteed(Attr::NONZERO)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::NONZERO:
-        return true;
+    using NodeType = Expr::NodeType;
 
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-        return f_x->guaranteed(a);
+    struct Instruction
+    {
+        NodeType op;
+        uint32_t x;
+        uint32_t y;
+    };
 
-    case Attr::UNITRANGE:
-        return f_x->guaranteed(Attr::ANTIOPENUNITRANGE);
+    static_assert(sizeof(Instruction) <= 16, "Instruction is meant to be compact");
 
-    case Attr::ANTIUNITRANGE:
-        return f_x->guaranteed(Attr::OPENUNITRANGE);
+    explicit data(Expr const*);
+    explicit data(std::vector<Expr const*> const&);  // Of a group, see 'results'
+    data(data const&, Variable const&);  // Derivative
 
-    case Attr::OPENUNITRANGE:
-        return f_x->guaranteed(Attr::ANTIUNITRANGE);
+    double run() const;
+    double run(double*) const;  // On registers of its own, that have the constants and the variables in place
+    double gradient(std::vector<Variable> const&, double*) const;
+    void sweep(double const*, double*, std::vector<Variable> const&, double*) const;  // Reverse, on registers of its own
+    double directional(std::vector<std::pair<Variable, std::vector<double>>> const&, double*) const;
+    std::vector<double> batch(std::vector<std::pair<Variable, std::vector<double>>> const&) const;
 
-    case Attr::ANTIOPENUNITRANGE:
-        return f_x->guaranteed(Attr::UNITRANGE);
+    static std::string source(std::vector<Expr const*> const&, std::string const&, std::vector<Variable> const&, bool);
 
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE);
+#if defined(LASKENTA_JIT)
+    ~data() noexcept;
+    Function native(std::vector<Variable> const&) const;
+    mutable std::vector<std::pair<void*, size_t>> natives;  // Blocks of machine code, released by the destructor
+#endif
 
-    case Attr::INCREASING:
-        return f_x->guaranteed(Attr::DECREASING) && (f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE));
+#if defined(LASKENTA_THREADS)
+    struct Task
+    {
+        uint32_t first;  // Instructions 'order[first]' to 'order[last - 1]'
+        uint32_t last;
+        uint32_t waits;  // For this many other tasks
+        std::vector<uint32_t> next;  // Tasks that wait for this one
+    };
 
-    case Attr::DECREASING:
-        return f_x->guaranteed(Attr::INCREASING) && (f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE));
+    double parallel() const;
+    void schedule() const;
+    mutable std::vector<uint32_t> order;  // Instructions grouped by task, in the order of 'code' within each
+    mutable std::vector<Task> tasks;  // Scheduled by the first 'parallel()'
+#endif
+
+    static int const LANES = 8;  // Values per register in 'batch()', a multiple of the SIMD width of the target
+
+    std::vector<Instruction> code;
+    std::vector<Variable> variables;
+    std::unordered_map<size_t, uint32_t> index;  // Register of each variable by 'Variable::id()'
+    mutable std::vector<double> registers;  // Constants first, then variables, then one register per instruction
+    mutable std::vector<double> adjoints;  // Partial derivative of the result with respect to each register
+    uint32_t constants;
+    uint32_t result;
+    std::vector<uint32_t> results;  // Register of each root, of which 'result' is the first
+};
 
-    case Attr::NONINCREASING:
-        return f_x->guaranteed(Attr::NONDECREASING) && (f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE));
+//----------------------------------------------------------------------------------------------------------------------
 
-    case Attr::NONDECREASING:
-        return f_x->guaranteed(Attr::NONINCREASING) && (f_x->guaranteed(Attr::POSITIVE) || f_x->guaranteed(Attr::NEGATIVE));
+static FORCEINLINE double compute(Expr::NodeType op, double x, double y)  // Inlined so that a constant 'op' folds the switch
+{
+    using NodeType = Expr::NodeType;
+
+    switch (op)
+    {
+    case NodeType::ABS: return std::abs(x);
+    case NodeType::SGN: return double(x > 0) - (x < 0);
+    case NodeType::SQRT: return std::sqrt(x);
+    case NodeType::CBRT: return std::cbrt(x);
+    case NodeType::EXP: return std::exp(x);
+    case NodeType::EXPM1: return std::expm1(x);
+    case NodeType::LOG: return std::log(x);
+    case NodeType::LOG1P: return std::log1p(x);
+    case NodeType::SIN: return std::sin(x);
+    case NodeType::COS: return std::cos(x);
+    case NodeType::TAN: return std::tan(x);
+    case NodeType::SEC: return 1 / std::cos(x);
+    case NodeType::ASIN: return std::asin(x);
+    case NodeType::ACOS: return std::acos(x);
+    case NodeType::ATAN: return std::atan(x);
+    case NodeType::SINH: return std::sinh(x);
+    case NodeType::COSH: return std::cosh(x);
+    case NodeType::TANH: return std::tanh(x);
+    case NodeType::SECH: return 1 / std::cosh(x);
+    case NodeType::ASINH: return std::asinh(x);
+    case NodeType::ACOSH: return std::acosh(x);
+    case NodeType::ATANH: return std::atanh(x);
+    case NodeType::ERF: return std::erf(x);
+    case NodeType::ERFC: return std::erfc(x);
+    case NodeType::INVERT: return 1 / x;
+    case NodeType::NEGATE: return -x;
+    case NodeType::SOFTPP: return Spp(x);
+    case NodeType::SPENCE: return Li2(x);
+    case NodeType::SQUARE: return x * x;
+    case NodeType::XCONIC: return std::sqrt(x * x - 1);
+    case NodeType::YCONIC: return std::sqrt(x * x + 1);
+    case NodeType::ZCONIC: return std::sqrt(1 - x * x);
+    case NodeType::ADD: return x + y;
+    case NodeType::MUL: return x == 0 || y == 0 ? 0 : x * y;  // Pruning as in 'Mul::value()', see the chains of 'data()'
+    case NodeType::POW: return std::pow(x, y);
+    default: return nan(__FUNCTION__);
     }
+}
 
-    return false;
+template <Expr::NodeType op> static void compute(double const* x, double const* y, double* z)
+{
+    for (int k = 0; k < CompiledExpression::data::LANES; ++k) z[k] = compute(op, x[k], y[k]);
 }
 
-bool Negate::guaranteed(Attr a) const
+static void compute(Expr::NodeType op, double const* x, double const* y, double* z)
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    using NodeType = Expr::NodeType;
+
+    switch (op)
     {
-    case Attr::DEFINED:
-        return true;
+    case NodeType::ABS: return compute<NodeType::ABS>(x, y, z);
+    case NodeType::SGN: return compute<NodeType::SGN>(x, y, z);
+    case NodeType::SQRT: return compute<NodeType::SQRT>(x, y, z);
+    case NodeType::CBRT: return compute<NodeType::CBRT>(x, y, z);
+    case NodeType::EXP: return compute<NodeType::EXP>(x, y, z);
+    case NodeType::EXPM1: return compute<NodeType::EXPM1>(x, y, z);
+    case NodeType::LOG: return compute<NodeType::LOG>(x, y, z);
+    case NodeType::LOG1P: return compute<NodeType::LOG1P>(x, y, z);
+    case NodeType::SIN: return compute<NodeType::SIN>(x, y, z);
+    case NodeType::COS: return compute<NodeType::COS>(x, y, z);
+    case NodeType::TAN: return compute<NodeType::TAN>(x, y, z);
+    case NodeType::SEC: return compute<NodeType::SEC>(x, y, z);
+    case NodeType::ASIN: return compute<NodeType::ASIN>(x, y, z);
+    case NodeType::ACOS: return compute<NodeType::ACOS>(x, y, z);
+    case NodeType::ATAN: return compute<NodeType::ATAN>(x, y, z);
+    case NodeType::SINH: return compute<NodeType::SINH>(x, y, z);
+    case NodeType::COSH: return compute<NodeType::COSH>(x, y, z);
+    case NodeType::TANH: return compute<NodeType::TANH>(x, y, z);
+    case NodeType::SECH: return compute<NodeType::SECH>(x, y, z);
+    case NodeType::ASINH: return compute<NodeType::ASINH>(x, y, z);
+    case NodeType::ACOSH: return compute<NodeType::ACOSH>(x, y, z);
+    case NodeType::ATANH: return compute<NodeType::ATANH>(x, y, z);
+    case NodeType::ERF: return compute<NodeType::ERF>(x, y, z);
+    case NodeType::ERFC: return compute<NodeType::ERFC>(x, y, z);
+    case NodeType::INVERT: return compute<NodeType::INVERT>(x, y, z);
+    case NodeType::NEGATE: return compute<NodeType::NEGATE>(x, y, z);
+    case NodeType::SOFTPP: return compute<NodeType::SOFTPP>(x, y, z);
+    case NodeType::SPENCE: return compute<NodeType::SPENCE>(x, y, z);
+    case NodeType::SQUARE: return compute<NodeType::SQUARE>(x, y, z);
+    case NodeType::XCONIC: return compute<NodeType::XCONIC>(x, y, z);
+    case NodeType::YCONIC: return compute<NodeType::YCONIC>(x, y, z);
+    case NodeType::ZCONIC: return compute<NodeType::ZCONIC>(x, y, z);
+    case NodeType::ADD: return compute<NodeType::ADD>(x, y, z);
+    case NodeType::MUL: return compute<NodeType::MUL>(x, y, z);
+    case NodeType::POW: return compute<NodeType::POW>(x, y, z);
+    default: return compute<NodeType::CONSTANT>(x, y, z);  // 'nan' as in 'run()'
+    }
+}
 
-    case Attr::NONZERO:
-    case Attr::UNITRANGE:
-    case Attr::ANTIUNITRANGE:
-    case Attr::OPENUNITRANGE:
-    case Attr::ANTIOPENUNITRANGE:
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a);
+static inline double product(double a, double b)
+{
+    return a == 0 || b == 0 ? 0 : a * b;  // Same pruning semantics as 'Mul::value()'
+}
 
-    case Attr::POSITIVE:
-        return f_x->guaranteed(Attr::NEGATIVE);
+static inline void accumulate(Expr::NodeType op, double x, double y, double z, double a, double& a_x, double& a_y)
+{
+    // Given 'z = op(x, y)' and the adjoint 'a' of 'z', add 'a * dz/dx' to 'a_x' and 'a * dz/dy' to 'a_y'.  The partial
+    // derivatives are the same as those of 'partial()' but computed from the values already on the tape.
 
-    case Attr::NEGATIVE:
-        return f_x->guaranteed(Attr::POSITIVE);
+    using NodeType = Expr::NodeType;
 
-    case Attr::NONPOSITIVE:
-        return f_x->guaranteed(Attr::NONNEGATIVE);
+    static double const InvSqrtAtan1 = 1 / std::sqrt(std::atan(1));
 
-    case Attr::NONNEGATIVE:
-        return f_x->guaranteed(Attr::NONPOSITIVE);
+    switch (op)
+    {
+    case NodeType::ABS: a_x += product(a, sgn(x)); return;
+    case NodeType::SGN: return;
+    case NodeType::SQRT: a_x += product(a, 1 / z / 2); return;
+    case NodeType::CBRT: a_x += product(a, 1 / (z * z) / 3); return;
+    case NodeType::EXP: a_x += product(a, z); return;
+    case NodeType::EXPM1: a_x += product(a, std::exp(x)); return;
+    case NodeType::LOG: a_x += product(a, 1 / x); return;
+    case NodeType::LOG1P: a_x += product(a, 1 / (x + 1)); return;
+    case NodeType::SIN: a_x += product(a, std::cos(x)); return;
+    case NodeType::COS: a_x += product(a, -std::sin(x)); return;
+    case NodeType::TAN: a_x += product(a, 1 / (std::cos(x) * std::cos(x))); return;
+    case NodeType::SEC: a_x += product(a, std::tan(x) * z); return;
+    case NodeType::ASIN: a_x += product(a, 1 / std::sqrt(1 - x * x)); return;
+    case NodeType::ACOS: a_x += product(a, -1 / std::sqrt(1 - x * x)); return;
+    case NodeType::ATAN: a_x += product(a, 1 / (x * x + 1)); return;
+    case NodeType::SINH: a_x += product(a, std::cosh(x)); return;
+    case NodeType::COSH: a_x += product(a, std::sinh(x)); return;
+    case NodeType::TANH: a_x += product(a, 1 / (std::cosh(x) * std::cosh(x))); return;
+    case NodeType::SECH: a_x += product(a, -std::tanh(x) * z); return;
+    case NodeType::ASINH: a_x += product(a, 1 / std::sqrt(x * x + 1)); return;
+    case NodeType::ACOSH: a_x += product(a, 1 / std::sqrt(x * x - 1)); return;
+    case NodeType::ATANH: a_x += product(a, 1 / (1 - x * x)); return;
+    case NodeType::ERF: a_x += product(a, InvSqrtAtan1 / std::exp(x * x)); return;
+    case NodeType::ERFC: a_x += product(a, -InvSqrtAtan1 / std::exp(x * x)); return;
+    case NodeType::INVERT: a_x += product(a, -z * z); return;
+    case NodeType::NEGATE: a_x -= a; return;
+    case NodeType::SOFTPP: a_x += product(a, std::log1p(std::exp(x))); return;
+    case NodeType::SPENCE: a_x += product(a, std::log1p(-x) / -x); return;
+    case NodeType::SQUARE: a_x += product(a, 2 * x); return;
+    case NodeType::XCONIC: a_x += product(a, x / z); return;
+    case NodeType::YCONIC: a_x += product(a, x / z); return;
+    case NodeType::ZCONIC: a_x += product(a, -x / z); return;
+    case NodeType::ADD: a_x += a; a_y += a; return;
+    case NodeType::MUL: a_x += product(a, y); a_y += product(a, x); return;
+    case NodeType::POW: a_x += product(a, product(y, std::pow(x, y - 1))); a_y += product(a, product(z, std::log(x))); return;
+    default: a_x = a_y = nan(__FUNCTION__); return;
+    }
+}
 
-    case Attr::INCREASING:
-        return f_x->guaranteed(Attr::DECREASING);
+//----------------------------------------------------------------------------------------------------------------------
 
-    case Attr::DECREASING:
-        return f_x->guaranteed(Attr::INCREASING);
+CompiledExpression::data::data(Expr const* root) : data(std::vector<Expr const*>{ root })
+{
+}
 
-    case Attr::NONINCREASING:
-        return f_x->guaranteed(Attr::NONDECREASING);
+CompiledExpression::data::data(std::vector<Expr const*> const& roots) : constants(0), result(0)
+{
+    // The nodes shared by the roots get one register each, so that the group is evaluated in a single pass
 
-    case Attr::NONDECREASING:
-        return f_x->guaranteed(Attr::NONINCREASING);
+    auto const order = topological(roots);
+    std::unordered_map<Expr const*, uint32_t> slot;
 
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(Attr::BOUNDEDBELOW);
+    // Allocate registers for the constants and the variables, followed by one register for each operation
 
-    case Attr::BOUNDEDBELOW:
-        return f_x->guaranteed(Attr::BOUNDEDABOVE);
+    for (auto p : order) if (p->type() == NodeType::CONSTANT)
+    {
+        slot[p] = uint32_t(registers.size());
+        registers.push_back(p->evaluate());
     }
 
-    return false;
-}
+    constants = uint32_t(registers.size());
 
-bool SoftPP::guaranteed(Attr a) const
-{
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    for (auto p : order) if (p->type() == NodeType::VARIABLE)
     {
-    case Attr::DEFINED:
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::UNITRANGE:
-    case Attr::ANTIUNITRANGE:
-    case Attr::OPENUNITRANGE:
-    case Attr::ANTIOPENUNITRANGE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        ;
+        slot[p] = uint32_t(registers.size());
+        index[static_cast<VariableNode const*>(p)->x.id()] = slot[p];
+        registers.push_back(0);
+        variables.push_back(static_cast<VariableNode const*>(p)->x);
     }
 
-    return false;
-}
-
-bool Spence::guaranteed(Attr a) const
-{
-    if (f_x->guaranteed(Attr::UNITRANGE) || f_x->guaranteed(Attr::NEGATIVE)) switch (a)
+    for (auto p : order) if (p->operand(0))
     {
-    case Attr::DEFINED:
-    case Attr::BOUNDEDABOVE:
-        return true;
+        auto f_x = p->operand(0);
+        auto g_x = p->operand(1);
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NEGATIVE:
-    case Attr::NONPOSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDBELOW:
-        return f_x->guaranteed(a);
+        slot[p] = uint32_t(registers.size());
+        registers.push_back(0);
+        code.push_back({ p->type(), slot[f_x], g_x ? slot[g_x] : 0 });
+
+        // N-ary sums and products become chains of binary instructions.  NOTE: A link of a product prunes whenever the
+        // product so far is 0, whereas 'Mul::value()' prunes on a zero factor only.  They differ where the partial product
+        // underflows to 0 ahead of an 'inf' or 'nan' factor, which gives 0 here and 'nan' there.
+
+        for (int i = 2; auto h_x = p->operand(i); ++i)
+        {
+            code.push_back({ p->type(), slot[p], slot[h_x] });
+            slot[p] = uint32_t(registers.size());
+            registers.push_back(0);
+        }
     }
 
-    return false;
+    for (auto root : roots) results.push_back(slot[root]);
+
+    if (!results.empty()) result = results.front();
+    adjoints.resize(registers.size());
 }
 
-bool Square::guaranteed(Attr a) const
+double CompiledExpression::data::run() const
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::NONNEGATIVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
-
-    case Attr::NONZERO:
-    case Attr::UNITRANGE:
-    case Attr::ANTIUNITRANGE:
-    case Attr::OPENUNITRANGE:
-    case Attr::ANTIOPENUNITRANGE:
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a);
+    double* const r = registers.data();
+    double* p = r + constants;
 
-    case Attr::POSITIVE:
-        return f_x->guaranteed(Attr::NONZERO);
+    for (auto& v : variables) *p++ = v();
+    for (auto& i : code) *p++ = compute(i.op, r[i.x], r[i.y]);
 
-    case Attr::INCREASING:
-        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
-        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
-        return false;
+    return r[result];
+}
 
-    case Attr::DECREASING:
-        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
-        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
-        return false;
+double CompiledExpression::data::run(double* r) const
+{
+    double* p = r + constants + variables.size();
 
-    case Attr::NONINCREASING:
-        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        return false;
+    for (auto& i : code) *p++ = compute(i.op, r[i.x], r[i.y]);
 
-    case Attr::NONDECREASING:
-        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        return false;
+    return r[result];
+}
 
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(Attr::BOUNDEDABOVE) && f_x->guaranteed(Attr::BOUNDEDBELOW);
-    }
+double CompiledExpression::data::gradient(std::vector<Variable> const& v, double* out) const
+{
+    // Forward sweep records every intermediate value in its register, the reverse sweep then propagates the adjoints
+    // from the result back to the variables.  Nothing but the adjoint registers is written; no nodes are created.
 
-    return false;
+    auto const value = run();
+    sweep(registers.data(), adjoints.data(), v, out);
+    return value;
 }
 
-bool XConic::guaranteed(Attr a) const
+void CompiledExpression::data::sweep(double const* r, double* a, std::vector<Variable> const& v, double* out) const
 {
-    if (f_x->guaranteed(Attr::POSITIVE) && f_x->guaranteed(Attr::ANTIOPENUNITRANGE)) switch (a)
+    auto const value = r[result];
+    uint32_t z = uint32_t(registers.size());
+
+    std::fill_n(a, registers.size(), 0.0);
+    a[result] = 1;
+
+    for (auto i = code.rbegin(); i != code.rend(); ++i)
     {
-    case Attr::DEFINED:
-    case Attr::NONNEGATIVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+        --z;
 
-    case Attr::CONTINUOUS:
-    case Attr::INCREASING:
-    case Attr::DECREASING:
-    case Attr::NONINCREASING:
-    case Attr::NONDECREASING:
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(a);
+        if (a[z] == 0) continue;  // Does not contribute to the result
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-        return f_x->guaranteed(Attr::ANTIUNITRANGE);
+        accumulate(i->op, r[i->x], r[i->y], r[z], a[z], a[i->x], a[i->y]);  // Unary operations leave 'a_y' alone
     }
 
-    return false;
+    auto const absent = code.empty() && isnan(value) ? value : 0;  // Like 'derivative()' the derivative of 'nan' is 'nan'
+
+    for (auto& x : v)
+    {
+        auto const p = index.find(x.id());
+        *out++ = p != index.end() ? a[p->second] : absent;
+    }
 }
 
-bool YConic::guaranteed(Attr a) const
+double CompiledExpression::data::directional(std::vector<std::pair<Variable, std::vector<double>>> const& d, double* out) const
 {
-    if (f_x->guaranteed(Attr::DEFINED)) switch (a)
+    // Forward mode: every register carries its value and one tangent per direction, the tangent of each instruction
+    // being the tangents of its operands times the partial derivatives that 'accumulate()' computes from the values.
+    // Instructions whose operands have no tangent are skipped.  Nothing but the tangents is written; no nodes are created.
+
+    auto const value = run();
+    auto const L = d.empty() ? 0 : d[0].second.size();
+    auto const R = registers.size();
+
+    std::vector<double> t(R * L);  // Tangents of register 'i' at 't[i * L]'
+    std::vector<bool> live(R);  // Has a tangent
+
+    for (auto& item : d)
     {
-    case Attr::DEFINED:
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NONNEGATIVE:
-    case Attr::ANTIOPENUNITRANGE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+        assert(item.second.size() == L);
 
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a);
+        auto p = index.find(item.first.id());
+        if (p == index.end()) continue;
 
-    case Attr::ANTIUNITRANGE:
-        return f_x->guaranteed(Attr::NONZERO);
+        std::copy_n(item.second.data(), L, &t[p->second * L]);
+        live[p->second] = true;
+    }
 
-    case Attr::INCREASING:
-        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
-        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
-        return false;
+    double const* const r = registers.data();
+    uint32_t z = uint32_t(constants + variables.size());
 
-    case Attr::DECREASING:
-        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
-        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
-        return false;
+    for (auto& i : code)
+    {
+        if (live[i.x] || (i.op >= NodeType::ADD && live[i.y]))
+        {
+            double d_x = 0;
+            double d_y = 0;
 
-    case Attr::NONINCREASING:
-        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        return false;
+            accumulate(i.op, r[i.x], r[i.y], r[z], 1, d_x, d_y);  // The adjoint 1 yields the partials themselves
 
-    case Attr::NONDECREASING:
-        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        return false;
+            for (size_t k = 0; k < L; ++k) t[z * L + k] = product(d_x, t[i.x * L + k]) + product(d_y, t[i.y * L + k]);
+            live[z] = true;
+        }
 
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(Attr::BOUNDEDABOVE) && f_x->guaranteed(Attr::BOUNDEDBELOW);
+        ++z;
     }
 
-    return false;
+    auto const absent = code.empty() && isnan(value) ? value : 0;  // Like 'derivative()' the derivative of 'nan' is 'nan'
+
+    for (size_t k = 0; k < L; ++k) out[k] = live[result] ? t[result * L + k] : absent;
+
+    return value;
 }
 
-bool ZConic::guaranteed(Attr a) const
+std::vector<double> CompiledExpression::data::batch(std::vector<std::pair<Variable, std::vector<double>>> const& r) const
 {
-    if (f_x->guaranteed(Attr::UNITRANGE)) switch (a)
+    // Same as 'run()' but each register holds 'LANES' values, so that every instruction is dispatched once per 'LANES'
+    // samples and the arithmetic runs in SIMD lanes.  Variables that are not listed keep their current value.
+
+    auto const N = r.empty() ? 0 : r[0].second.size();
+    auto const R = registers.size();
+
+    std::vector<double const*> source(variables.size());
+    std::vector<double> values(N);
+    std::vector<double> lanes(R * LANES);
+
+    for (auto& item : r)
     {
-    case Attr::DEFINED:
-    case Attr::NONNEGATIVE:
-    case Attr::UNITRANGE:
-    case Attr::BOUNDEDABOVE:
-    case Attr::BOUNDEDBELOW:
-        return true;
+        assert(item.second.size() == N);
 
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a);
+        auto p = index.find(item.first.id());
+        if (p != index.end()) source[p->second - constants] = item.second.data();
+    }
 
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-        return f_x->guaranteed(Attr::OPENUNITRANGE);
+    for (uint32_t i = 0; i < constants; ++i) std::fill_n(&lanes[i * LANES], LANES, registers[i]);
 
-    case Attr::NONPOSITIVE:
-        return f_x->guaranteed(Attr::ANTIOPENUNITRANGE);
+    for (size_t n = 0; n < N; n += LANES)
+    {
+        auto const M = std::min<size_t>(LANES, N - n);  // The unused lanes of the last block repeat its last sample
 
-    case Attr::OPENUNITRANGE:
-        return f_x->guaranteed(Attr::NONZERO);
+        for (size_t i = 0; i < variables.size(); ++i)
+        {
+            double* p = &lanes[(constants + i) * LANES];
 
-    case Attr::INCREASING:
-        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
-        return false;
+            for (size_t k = 0; k < LANES; ++k) p[k] = source[i] ? source[i][n + std::min<size_t>(k, M - 1)] : variables[i]();
+        }
 
-    case Attr::DECREASING:
-        if (f_x->guaranteed(Attr::DECREASING) && f_x->guaranteed(Attr::NEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::INCREASING) && f_x->guaranteed(Attr::POSITIVE)) return true;
-        return false;
+        double* p = &lanes[(constants + variables.size()) * LANES];
 
-    case Attr::NONINCREASING:
-        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        return false;
+        for (auto& i : code)
+        {
+            compute(i.op, &lanes[i.x * LANES], &lanes[i.y * LANES], p);
+            p += LANES;
+        }
 
-    case Attr::NONDECREASING:
-        if (f_x->guaranteed(Attr::NONDECREASING) && f_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        if (f_x->guaranteed(Attr::NONINCREASING) && f_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        return false;
+        std::copy_n(&lanes[result * LANES], M, &values[n]);
     }
 
-    return false;
+    return values;
 }
 
-bool Add::guaranteed(Attr a) const
+CompiledExpression::data::data(data const& f, Variable const& v) : constants(0), result(0)
 {
-    if (f_x->guaranteed(Attr::DEFINED) && g_x->guaranteed(Attr::DEFINED)) switch (a)
+    // Derive on the tape itself: every instruction of 'f' gets a tangent computed by new instructions, dispatching on
+    // the opcode like 'accumulate()' does.  Values are first numbered in a single space (the registers of 'f' followed
+    // by the new constants and instructions), then only those the tangent of the result depends on are laid out.
+
+    static uint32_t const ZERO = ~uint32_t(0);  // Tangent that is known to vanish
+    static double const InvSqrtAtan1 = 1 / std::sqrt(std::atan(1));
+
+    auto const R = uint32_t(f.registers.size());
+
+    std::vector<Instruction> ops;  // Operations beyond the registers of 'f', in order
+    std::vector<double> values(f.registers.begin(), f.registers.begin() + f.constants);  // Values of the constants
+    std::vector<uint32_t> held(f.constants);  // Number of each constant, whether taken from 'f' or new
+    std::unordered_map<double, uint32_t> known;
+
+    for (uint32_t i = 0; i < f.constants; ++i)
     {
-    case Attr::DEFINED:
-        return true;
+        held[i] = i;
+        known.emplace(f.registers[i], i);
+    }
 
-    case Attr::NONZERO:
-        if (f_x->guaranteed(Attr::POSITIVE) && g_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NEGATIVE) && g_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        if (f_x->guaranteed(Attr::NONPOSITIVE) && g_x->guaranteed(Attr::NEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NONNEGATIVE) && g_x->guaranteed(Attr::POSITIVE)) return true;
-        return false;
+    auto const emit = [&](NodeType op, uint32_t x, uint32_t y) { ops.push_back({ op, x, y }); return R + uint32_t(ops.size() - 1); };
+    auto const unary = [&](NodeType op, uint32_t x) { return emit(op, x, 0); };
 
-    case Attr::POSITIVE:
-        if (f_x->guaranteed(Attr::POSITIVE) && g_x->guaranteed(Attr::NONNEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NONNEGATIVE) && g_x->guaranteed(Attr::POSITIVE)) return true;
-        return false;
+    auto const constant = [&](double d)
+    {
+        auto p = known.find(d);
+        if (p != known.end()) return p->second;
+
+        auto const n = emit(NodeType::CONSTANT, uint32_t(values.size()), 0);
+        values.push_back(d);
+        held.push_back(n);
+        known.emplace(d, n);
+        return n;
+    };
 
-    case Attr::NEGATIVE:
-        if (f_x->guaranteed(Attr::NEGATIVE) && g_x->guaranteed(Attr::NONPOSITIVE)) return true;
-        if (f_x->guaranteed(Attr::NONPOSITIVE) && g_x->guaranteed(Attr::NEGATIVE)) return true;
-        return false;
+    auto const add = [&](uint32_t a, uint32_t b) { return a == ZERO ? b : b == ZERO ? a : emit(NodeType::ADD, a, b); };
+    auto const mul = [&](uint32_t a, uint32_t b) { return a == ZERO || b == ZERO ? ZERO : emit(NodeType::MUL, a, b); };
+    auto const div = [&](uint32_t a, uint32_t b) { return a == ZERO ? ZERO : emit(NodeType::MUL, a, unary(NodeType::INVERT, b)); };
+    auto const neg = [&](uint32_t a) { return a == ZERO ? ZERO : unary(NodeType::NEGATE, a); };
 
-    case Attr::NONPOSITIVE:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+    std::vector<uint32_t> tangent(R, ZERO);
 
-    case Attr::NONNEGATIVE:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+    for (uint32_t i = 0; i < f.variables.size(); ++i) if (f.variables[i].id() == v.id()) tangent[f.constants + i] = constant(1);
 
-    case Attr::UNITRANGE:
-        break;
+    auto z = uint32_t(f.constants + f.variables.size());
 
-    case Attr::ANTIUNITRANGE:
-        break;
+    for (auto& i : f.code)
+    {
+        auto const x = i.x;
+        auto const y = i.y;
+        auto const dx = tangent[x];
+        auto& dz = tangent[z];
 
-    case Attr::OPENUNITRANGE:
-        break;
+        if (dx == ZERO && (i.op < NodeType::ADD || tangent[y] == ZERO))
+        {
+            ++z;
+            continue;
+        }
 
-    case Attr::ANTIOPENUNITRANGE:
-        break;
+        switch (i.op)
+        {
+        case NodeType::ABS: dz = mul(dx, unary(NodeType::SGN, x)); break;
+        case NodeType::SGN: break;
+        case NodeType::SQRT: dz = div(dx, add(z, z)); break;
+        case NodeType::CBRT: dz = div(dx, mul(constant(3), unary(NodeType::SQUARE, z))); break;
+        case NodeType::EXP: dz = mul(dx, z); break;
+        case NodeType::EXPM1: dz = mul(dx, unary(NodeType::EXP, x)); break;
+        case NodeType::LOG: dz = div(dx, x); break;
+        case NodeType::LOG1P: dz = div(dx, add(x, constant(1))); break;
+        case NodeType::SIN: dz = mul(dx, unary(NodeType::COS, x)); break;
+        case NodeType::COS: dz = neg(mul(dx, unary(NodeType::SIN, x))); break;
+        case NodeType::TAN: dz = mul(dx, unary(NodeType::SQUARE, unary(NodeType::SEC, x))); break;
+        case NodeType::SEC: dz = mul(dx, mul(unary(NodeType::TAN, x), z)); break;
+        case NodeType::ASIN: dz = div(dx, unary(NodeType::ZCONIC, x)); break;
+        case NodeType::ACOS: dz = neg(div(dx, unary(NodeType::ZCONIC, x))); break;
+        case NodeType::ATAN: dz = div(dx, add(unary(NodeType::SQUARE, x), constant(1))); break;
+        case NodeType::SINH: dz = mul(dx, unary(NodeType::COSH, x)); break;
+        case NodeType::COSH: dz = mul(dx, unary(NodeType::SINH, x)); break;
+        case NodeType::TANH: dz = mul(dx, unary(NodeType::SQUARE, unary(NodeType::SECH, x))); break;
+        case NodeType::SECH: dz = neg(mul(dx, mul(unary(NodeType::TANH, x), z))); break;
+        case NodeType::ASINH: dz = div(dx, unary(NodeType::YCONIC, x)); break;
+        case NodeType::ACOSH: dz = div(dx, unary(NodeType::XCONIC, x)); break;
+        case NodeType::ATANH: dz = div(dx, add(constant(1), neg(unary(NodeType::SQUARE, x)))); break;
+        case NodeType::ERF: dz = mul(dx, div(constant(InvSqrtAtan1), unary(NodeType::EXP, unary(NodeType::SQUARE, x)))); break;
+        case NodeType::ERFC: dz = mul(dx, div(constant(-InvSqrtAtan1), unary(NodeType::EXP, unary(NodeType::SQUARE, x)))); break;
+        case NodeType::INVERT: dz = neg(mul(dx, unary(NodeType::SQUARE, z))); break;
+        case NodeType::NEGATE: dz = neg(dx); break;
+        case NodeType::SOFTPP: dz = mul(dx, unary(NodeType::LOG1P, unary(NodeType::EXP, x))); break;
+        case NodeType::SPENCE: dz = mul(dx, div(unary(NodeType::LOG1P, neg(x)), neg(x))); break;
+        case NodeType::SQUARE: dz = mul(dx, add(x, x)); break;
+        case NodeType::XCONIC: dz = mul(dx, div(x, z)); break;
+        case NodeType::YCONIC: dz = mul(dx, div(x, z)); break;
+        case NodeType::ZCONIC: dz = neg(mul(dx, div(x, z))); break;
+        case NodeType::ADD: dz = add(dx, tangent[y]); break;
+        case NodeType::MUL: dz = add(mul(dx, y), mul(x, tangent[y])); break;
+        case NodeType::POW: dz = add(mul(dx, mul(y, emit(NodeType::POW, x, add(y, constant(-1))))), mul(tangent[y], mul(z, unary(NodeType::LOG, x)))); break;
+        default: dz = constant(nan(__FUNCTION__)); break;
+        }
 
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+        ++z;
+    }
 
-    case Attr::INCREASING:
-        if (f_x->guaranteed(Attr::INCREASING) && g_x->guaranteed(Attr::NONDECREASING)) return true;
-        if (f_x->guaranteed(Attr::NONDECREASING) && g_x->guaranteed(Attr::INCREASING)) return true;
-        return false;
+    auto const root = tangent[f.result] == ZERO ? constant(0) : tangent[f.result];
 
-    case Attr::DECREASING:
-        if (f_x->guaranteed(Attr::DECREASING) && g_x->guaranteed(Attr::NONINCREASING)) return true;
-        if (f_x->guaranteed(Attr::NONINCREASING) && g_x->guaranteed(Attr::DECREASING)) return true;
-        return false;
+    // Mark what the result depends on; every value refers to values numbered before it, so one reverse pass suffices
 
-    case Attr::NONINCREASING:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+    auto const N = R + uint32_t(ops.size());
+    auto const source = [&](uint32_t n) { return n < R ? f.code[n - f.constants - f.variables.size()] : ops[n - R]; };
 
-    case Attr::NONDECREASING:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+    std::vector<uint32_t> slot(N, ZERO);  // Register of each live value, ZERO for the dead ones
+    std::vector<bool> live(N);
+    live[root] = true;
 
-    case Attr::BOUNDEDABOVE:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+    for (auto n = N; n-- > f.constants + f.variables.size(); ) if (live[n])
+    {
+        auto const& i = source(n);
+        if (i.op == NodeType::CONSTANT) continue;
 
-    case Attr::BOUNDEDBELOW:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+        live[i.x] = true;
+        if (i.op >= NodeType::ADD) live[i.y] = true;
     }
 
-    return false;
-}
+    // Allocate registers for the constants and the variables, followed by one register for each operation
 
-bool Mul::guaranteed(Attr a) const
-{
-    if (f_x->guaranteed(Attr::DEFINED) && g_x->guaranteed(Attr::DEFINED)) switch (a)
+    for (uint32_t i = 0; i < held.size(); ++i) if (live[held[i]])
     {
-    case Attr::DEFINED:
-        return true;
+        slot[held[i]] = uint32_t(registers.size());
+        registers.push_back(values[i]);
+    }
 
-    case Attr::NONZERO:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+    constants = uint32_t(registers.size());
 
-    case Attr::POSITIVE:
-        if (f_x->guaranteed(Attr::POSITIVE) && g_x->guaranteed(Attr::POSITIVE)) return true;
-        if (f_x->guaranteed(Attr::NEGATIVE) && g_x->guaranteed(Attr::NEGATIVE)) return true;
-        return false;
+    for (uint32_t i = 0; i < f.variables.size(); ++i) if (live[f.constants + i])
+    {
+        slot[f.constants + i] = uint32_t(registers.size());
+        index[f.variables[i].id()] = slot[f.constants + i];
+        registers.push_back(0);
+        variables.push_back(f.variables[i]);
+    }
 
-    case Attr::NEGATIVE:
-        if (f_x->guaranteed(Attr::POSITIVE) && g_x->guaranteed(Attr::NEGATIVE)) return true;
-        if (f_x->guaranteed(Attr::NEGATIVE) && g_x->guaranteed(Attr::POSITIVE)) return true;
-        return false;
+    for (auto n = uint32_t(f.constants + f.variables.size()); n < N; ++n) if (live[n])
+    {
+        auto const& i = source(n);
+        if (i.op == NodeType::CONSTANT) continue;
 
-    case Attr::NONPOSITIVE:
-        break;
+        slot[n] = uint32_t(registers.size());
+        registers.push_back(0);
+        code.push_back({ i.op, slot[i.x], i.op >= NodeType::ADD ? slot[i.y] : 0 });
+    }
 
-    case Attr::NONNEGATIVE:
-        break;
+    result = slot[root];
+    results.push_back(result);
+    adjoints.resize(registers.size());
+}
 
-    case Attr::UNITRANGE:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+std::string CompiledExpression::data::source(std::vector<Expr const*> const& roots, std::string const& name, std::vector<Variable> const& parameters, bool group)
+{
+    // C++ source of a function that computes the roots from the parameters 'x[i]': one local per shared node in the
+    // topological order, each computed exactly as its 'value()' computes it, so that the function returns the same
+    // bits as 'Expression::Evaluate()'.  NOTE: That takes a compiler that neither contracts nor reassociates the
+    // arithmetic nor folds the math functions where it finds their arguments constant (with GCC '-ffp-contract=off
+    // -fno-builtin').  The variables that are not parameters are frozen at their current values.
 
-    case Attr::ANTIUNITRANGE:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+    std::unordered_map<Expr const*, size_t> local;
+    std::unordered_map<size_t, size_t> parameter;  // Index of each parameter by 'Variable::id()'
+    std::ostringstream body;
+    auto li2 = false;
+    auto spp = false;
 
-    case Attr::OPENUNITRANGE:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+    for (size_t i = 0; i < parameters.size(); ++i) parameter.emplace(parameters[i].id(), i);
 
-    case Attr::ANTIOPENUNITRANGE:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+    auto const t = [&local](Expr const* p) { return "t" + std::to_string(local.at(p)); };
 
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+    auto const literal = [](double d) -> std::string
+    {
+        if (isnan(d)) return "NAN";
+        if (isinf(d)) return d > 0 ? "HUGE_VAL" : "-HUGE_VAL";
 
-    case Attr::INCREASING:
-        break;
+        std::ostringstream out;
+        out << std::setprecision(17) << d;  // Enough digits to read back the same bits
 
-    case Attr::DECREASING:
-        break;
+        auto s = out.str();
+        return s.find_first_of(".e") == std::string::npos ? s + ".0" : s;  // Keeps '-0' a negative zero
+    };
 
-    case Attr::NONINCREASING:
-        break;
+    for (auto root : roots) postorder(root, [&local](Expr const* p)
+    {
+        return local.count(p) != 0;
+    }, [&](Expr const* p)
+    {
+        auto const x = p->operand(0) ? t(p->operand(0)) : "";
+        auto const y = p->operand(1) ? t(p->operand(1)) : "";
 
-    case Attr::NONDECREASING:
-        break;
+        body << "    double const t" << local.size() << " = ";
 
-    case Attr::BOUNDEDABOVE:
-        break;
+        switch (p->type())
+        {
+        case NodeType::CONSTANT:
+            body << literal(p->evaluate());
+            break;
 
-    case Attr::BOUNDEDBELOW:
-        break;
-    }
+        case NodeType::VARIABLE:
+            {
+                auto item = parameter.find(static_cast<VariableNode const*>(p)->x.id());
+                if (item != parameter.end()) body << "x[" << item->second << "]"; else body << literal(p->evaluate());
+            }
+            break;
+
+        case NodeType::ABS: body << "std::abs(" << x << ")"; break;
+        case NodeType::SGN: body << "double(" << x << " > 0) - (" << x << " < 0)"; break;
+        case NodeType::SQRT: body << "std::sqrt(" << x << ")"; break;
+        case NodeType::CBRT: body << "std::cbrt(" << x << ")"; break;
+        case NodeType::EXP: body << "std::exp(" << x << ")"; break;
+        case NodeType::EXPM1: body << "std::expm1(" << x << ")"; break;
+        case NodeType::LOG: body << "std::log(" << x << ")"; break;
+        case NodeType::LOG1P: body << "std::log1p(" << x << ")"; break;
+        case NodeType::SIN: body << "std::sin(" << x << ")"; break;
+        case NodeType::COS: body << "std::cos(" << x << ")"; break;
+        case NodeType::TAN: body << "std::tan(" << x << ")"; break;
+        case NodeType::SEC: body << "1 / std::cos(" << x << ")"; break;
+        case NodeType::ASIN: body << "std::asin(" << x << ")"; break;
+        case NodeType::ACOS: body << "std::acos(" << x << ")"; break;
+        case NodeType::ATAN: body << "std::atan(" << x << ")"; break;
+        case NodeType::SINH: body << "std::sinh(" << x << ")"; break;
+        case NodeType::COSH: body << "std::cosh(" << x << ")"; break;
+        case NodeType::TANH: body << "std::tanh(" << x << ")"; break;
+        case NodeType::SECH: body << "1 / std::cosh(" << x << ")"; break;
+        case NodeType::ASINH: body << "std::asinh(" << x << ")"; break;
+        case NodeType::ACOSH: body << "std::acosh(" << x << ")"; break;
+        case NodeType::ATANH: body << "std::atanh(" << x << ")"; break;
+        case NodeType::ERF: body << "std::erf(" << x << ")"; break;
+        case NodeType::ERFC: body << "std::erfc(" << x << ")"; break;
+        case NodeType::INVERT: body << "1 / " << x; break;
+        case NodeType::NEGATE: body << "-" << x; break;
+        case NodeType::SOFTPP: body << "::Spp(" << x << ")"; spp = true; break;
+        case NodeType::SPENCE: body << "::Li2(" << x << ")"; li2 = true; break;
+        case NodeType::SQUARE: body << x << " * " << x; break;
+        case NodeType::XCONIC: body << "std::sqrt(" << x << " * " << x << " - 1)"; break;
+        case NodeType::YCONIC: body << "std::sqrt(" << x << " * " << x << " + 1)"; break;
+        case NodeType::ZCONIC: body << "std::sqrt(1 - " << x << " * " << x << ")"; break;
+        case NodeType::POW: body << "std::pow(" << x << ", " << y << ")"; break;
+
+        case NodeType::ADD:  // Starts from 0 as 'Add::value()' does, so that a sum of negative zeros is a positive zero
+            body << "0.0";
+            for (int i = 0; auto q = p->operand(i); ++i) body << " + " << t(q);
+            break;
+
+        case NodeType::MUL:  // A zero factor prunes the rest as in 'Mul::value()'
+            for (int i = 0; auto q = p->operand(i); ++i) body << (i ? " || " : "") << t(q) << " == 0";
+            body << " ? 0.0 : ";
+            for (int i = 0; auto q = p->operand(i); ++i) body << (i ? " * " : "") << t(q);
+            break;
+        }
 
-    return false;
-}
+        body << ";\n";
+        local.emplace(p, local.size());
+    });
 
-bool Pow::guaranteed(Attr a) const
-{
-    if (f_x->guaranteed(Attr::POSITIVE) && g_x->guaranteed(Attr::DEFINED)) switch (a)
-    {
-    case Attr::DEFINED:
-    case Attr::NONZERO:
-    case Attr::POSITIVE:
-    case Attr::NONNEGATIVE:
-        return true;
+    std::ostringstream out;
 
-    case Attr::UNITRANGE:
-        break;
+    out << "#include <cmath>\n\n";
+    if (li2) out << "double Li2(double);  // Polylog2, see 'Laskenta.h'\n";
+    if (spp) out << "double Spp(double);  // Integral of Softplus, see 'Laskenta.h'\n";
+    if (li2 || spp) out << "\n";
 
-    case Attr::ANTIUNITRANGE:
-        break;
+    out << (group ? "void " : "double ") << name << (group ? "(double const* x, double* y)\n{\n" : "(double const* x)\n{\n") << body.str();
 
-    case Attr::OPENUNITRANGE:
-        break;
+    if (group) for (size_t i = 0; i < roots.size(); ++i) out << "    y[" << i << "] = " << t(roots[i]) << ";\n";
+    else out << "    return " << t(roots[0]) << ";\n";
 
-    case Attr::ANTIOPENUNITRANGE:
-        break;
+    out << "}\n";
 
-    case Attr::CONTINUOUS:
-        return f_x->guaranteed(a) && g_x->guaranteed(a);
+    return out.str();
+}
 
-    case Attr::INCREASING:
-        break;
+#if defined(LASKENTA_THREADS)
 
-    case Attr::DECREASING:
-        break;
+struct WorkPool final  // Threads that perform the tasks of 'parallel()', stealing them from each other when out of work
+{
+    using data = CompiledExpression::data;
 
-    case Attr::NONINCREASING:
-        break;
+    static WorkPool& instance();
 
-    case Attr::NONDECREASING:
-        break;
+    size_t size() const { return queues.size(); }  // The calling thread included
+    void run(data const&, double*);
 
-    case Attr::BOUNDEDABOVE:
-        break;
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<uint32_t> tasks;  // The owner takes the newest task, the others steal the oldest
+    };
 
-    case Attr::BOUNDEDBELOW:
-        break;
-    }
+    explicit WorkPool(size_t);
 
-    return false;
-}
+    void work(size_t);
+    void drain(size_t);
+    bool take(size_t, uint32_t&);
+    void give(size_t, uint32_t);
 
-/***********************************************************************************************************************
-*** print()
-***********************************************************************************************************************/
+    std::vector<Queue> queues;
 
-void ConstantNode::print(std::ostream& out) const
-{
-    out << n;
-}
+    std::mutex serial;  // One job at a time
+    data const* job;
+    double* registers;
+    std::unique_ptr<std::atomic<uint32_t>[]> waits;  // Of each task of the job, for the tasks that are not done yet
+    size_t capacity;
+    std::atomic<size_t> remaining;  // Tasks of the job that are not done
 
-void VariableNode::print(std::ostream& out) const
-{
-    out << x.Name();
-}
+    std::mutex mutex;  // Of the following
+    std::condition_variable wake;
+    std::condition_variable idle;
+    size_t generation;  // Of the job, a new one wakes the workers
+    size_t busy;  // Workers that have not yet left the job
+};
 
-void Abs::print(std::ostream& out) const
-{
-    out << "abs(";
-    f_x->print(out);
-    out << ")";
-}
+//----------------------------------------------------------------------------------------------------------------------
 
-void Sgn::print(std::ostream& out) const
+WorkPool& WorkPool::instance()
 {
-    out << "sgn(";
-    f_x->print(out);
-    out << ")";
+    static auto& pool = *new WorkPool(std::max(1u, std::thread::hardware_concurrency()));  // Never destroyed, the workers never leave
+    return pool;
 }
 
-void Sqrt::print(std::ostream& out) const
+WorkPool::WorkPool(size_t n) : queues(n), job(nullptr), registers(nullptr), capacity(0), remaining(0), generation(0), busy(0)
 {
-    out << "sqrt(";
-    f_x->print(out);
-    out << ")";
+    for (size_t w = 1; w < n; ++w) std::thread(&WorkPool::work, this, w).detach();
 }
 
-void Cbrt::print(std::ostream& out) const
+void WorkPool::run(data const& d, double* r)
 {
-    out << "cbrt(";
-    f_x->print(out);
-    out << ")";
-}
+    std::lock_guard<std::mutex> one(serial);
 
-void Exp::print(std::ostream& out) const
-{
-    out << "exp(";
-    f_x->print(out);
-    out << ")";
-}
+    if (capacity < d.tasks.size())
+    {
+        capacity = d.tasks.size();
+        waits.reset(new std::atomic<uint32_t>[capacity]);
+    }
 
-void ExpM1::print(std::ostream& out) const
-{
-    out << "expm1(";
-    f_x->print(out);
-    out << ")";
-}
+    job = &d;
+    registers = r;
+    remaining = d.tasks.size();
 
-void Log::print(std::ostream& out) const
-{
-    out << "log(";
-    f_x->print(out);
-    out << ")";
-}
+    size_t w = 0;
 
-void Log1P::print(std::ostream& out) const
-{
-    out << "log1p(";
-    f_x->print(out);
-    out << ")";
-}
+    for (uint32_t t = 0; t < d.tasks.size(); ++t)
+    {
+        waits[t] = d.tasks[t].waits;
+        if (!d.tasks[t].waits) give(w++ % size(), t);  // The tasks that are ready are dealt out to all the workers
+    }
 
-void Sin::print(std::ostream& out) const
-{
-    out << "sin(";
-    f_x->print(out);
-    out << ")";
-}
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+        busy = size() - 1;
+    }
 
-void Cos::print(std::ostream& out) const
-{
-    out << "cos(";
-    f_x->print(out);
-    out << ")";
-}
+    wake.notify_all();
+    drain(0);
 
-void Tan::print(std::ostream& out) const
-{
-    out << "tan(";
-    f_x->print(out);
-    out << ")";
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return !busy; });
 }
 
-void Sec::print(std::ostream& out) const
+void WorkPool::work(size_t w)
 {
-    out << "sec(";
-    f_x->print(out);
-    out << ")";
-}
+    size_t seen = 0;
 
-void ASin::print(std::ostream& out) const
-{
-    out << "asin(";
-    f_x->print(out);
-    out << ")";
-}
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen] { return generation != seen; });
+            seen = generation;
+        }
 
-void ACos::print(std::ostream& out) const
-{
-    out << "acos(";
-    f_x->print(out);
-    out << ")";
-}
+        drain(w);
 
-void ATan::print(std::ostream& out) const
-{
-    out << "atan(";
-    f_x->print(out);
-    out << ")";
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!--busy) idle.notify_one();
+    }
 }
 
-void SinH::print(std::ostream& out) const
+void WorkPool::drain(size_t w)
 {
-    out << "sinh(";
-    f_x->print(out);
-    out << ")";
-}
+    auto const base = job->constants + uint32_t(job->variables.size());
+    auto const r = registers;
 
-void CosH::print(std::ostream& out) const
-{
-    out << "cosh(";
-    f_x->print(out);
-    out << ")";
-}
+    while (remaining)
+    {
+        uint32_t t;
 
-void TanH::print(std::ostream& out) const
-{
-    out << "tanh(";
-    f_x->print(out);
-    out << ")";
-}
+        if (!take(w, t))
+        {
+            std::this_thread::yield();
+            continue;
+        }
 
-void SecH::print(std::ostream& out) const
-{
-    out << "sech(";
-    f_x->print(out);
-    out << ")";
-}
+        auto& task = job->tasks[t];
 
-void ASinH::print(std::ostream& out) const
-{
-    out << "asinh(";
-    f_x->print(out);
-    out << ")";
-}
+        for (auto n = task.first; n < task.last; ++n)
+        {
+            auto const k = job->order[n];
+            auto& i = job->code[k];
+            r[base + k] = compute(i.op, r[i.x], r[i.y]);
+        }
 
-void ACosH::print(std::ostream& out) const
-{
-    out << "acosh(";
-    f_x->print(out);
-    out << ")";
-}
+        for (auto s : task.next) if (!--waits[s]) give(w, s);  // Ready once the last task it waits for is done
 
-void ATanH::print(std::ostream& out) const
-{
-    out << "atanh(";
-    f_x->print(out);
-    out << ")";
+        --remaining;
+    }
 }
 
-void Erf::print(std::ostream& out) const
+bool WorkPool::take(size_t w, uint32_t& t)
 {
-    out << "erf(";
-    f_x->print(out);
-    out << ")";
-}
+    for (size_t n = 0; n < size(); ++n)
+    {
+        auto& q = queues[(w + n) % size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
 
-void ErfC::print(std::ostream& out) const
-{
-    out << "erfc(";
-    f_x->print(out);
-    out << ")";
+        if (q.tasks.empty()) continue;
+
+        if (n) { t = q.tasks.front(); q.tasks.pop_front(); }
+        else { t = q.tasks.back(); q.tasks.pop_back(); }
+
+        return true;
+    }
+
+    return false;
 }
 
-void Invert::print(std::ostream& out) const
+void WorkPool::give(size_t w, uint32_t t)
 {
-    out << "1/(";
-    f_x->print(out);
-    out << ")";
+    std::lock_guard<std::mutex> lock(queues[w].mutex);
+    queues[w].tasks.push_back(t);
 }
 
-void Negate::print(std::ostream& out) const
+//----------------------------------------------------------------------------------------------------------------------
+
+void CompiledExpression::data::schedule() const
 {
-    out << "-";
-    if (f_x->is(NodeType::ADD)) out << "(";
-    f_x->print(out);
-    if (f_x->is(NodeType::ADD)) out << ")";
+    // An instruction whose value is used by one other only joins the task of that one, until the task is as long as it
+    // may be.  The others, like the nodes shared by several subexpressions, begin tasks of their own.  So each task is
+    // a tree that computes its last instruction, and the other tasks wait for that one only.
+
+    auto const base = constants + uint32_t(variables.size());
+    auto const N = uint32_t(code.size());
+    auto const limit = std::max<uint32_t>(64, N / uint32_t(8 * WorkPool::instance().size()));  // Several tasks per worker
+
+    std::vector<uint32_t> uses(N), user(N), task(N), size;
+
+    for (uint32_t k = 0; k < N; ++k) for (auto z : { code[k].x, code[k].y }) if (z >= base)
+    {
+        ++uses[z - base];
+        user[z - base] = k;
+    }
+
+    for (auto k = N; k-- > 0;)  // Users first
+    {
+        if (uses[k] == 1 && size[task[user[k]]] < limit)
+        {
+            task[k] = task[user[k]];
+        }
+        else
+        {
+            task[k] = uint32_t(size.size());
+            size.push_back(0);
+        }
+
+        ++size[task[k]];
+    }
+
+    tasks.assign(size.size(), Task{ 0, 0, 0, {} });
+    order.resize(N);
+
+    for (uint32_t t = 0, n = 0; t < size.size(); n += size[t++]) tasks[t].first = tasks[t].last = n;
+
+    for (uint32_t k = 0; k < N; ++k)
+    {
+        auto& t = tasks[task[k]];
+        order[t.last++] = k;
+
+        for (auto z : { code[k].x, code[k].y }) if (z >= base && task[z - base] != task[k])
+        {
+            tasks[task[z - base]].next.push_back(task[k]);  // Repeated for each use, and so are the waits
+            ++t.waits;
+        }
+    }
 }
 
-void SoftPP::print(std::ostream& out) const
+double CompiledExpression::data::parallel() const
 {
-    out << "softpp(";
-    f_x->print(out);
-    out << ")";
+    // Same as 'run()' on the same registers, but the tasks that do not wait for each other may run at the same time
+
+    double* const r = registers.data();
+    double* p = r + constants;
+
+    for (auto& v : variables) *p++ = v();
+
+    if (WorkPool::instance().size() < 2) return run(r);
+    if (tasks.empty()) schedule();
+
+    if (tasks.size() > 1) WorkPool::instance().run(*this, r); else run(r);
+
+    return r[result];
 }
 
-void Spence::print(std::ostream& out) const
+#endif
+
+#if defined(LASKENTA_JIT)
+
+struct Emitter  // Encodes the few x86-64 instructions that 'native()' needs
 {
-    out << "Li2(";
-    f_x->print(out);
-    out << ")";
-}
+    static uint8_t const RAX = 0;
+    static uint8_t const RCX = 1;
+    static uint8_t const RBX = 3;
+    static uint8_t const RDI = 7;
+    static uint8_t const R12 = 12;
+
+    void bytes(std::initializer_list<uint8_t> r) { code.insert(code.end(), r); }
+    void imm32(uint32_t n) { for (int i = 0; i < 4; ++i) code.push_back(uint8_t(n >> 8 * i)); }
+    void imm64(uint64_t n) { for (int i = 0; i < 8; ++i) code.push_back(uint8_t(n >> 8 * i)); }
+
+    void address(uint8_t r, uint8_t base, int32_t offset)  // ModRM of [base+offset], with an 8-bit offset if it fits
+    {
+        auto const small = offset >= -128 && offset < 128;
+
+        code.push_back(uint8_t((small ? 0x40 : 0x80) | (r & 7) << 3 | (base & 7)));
+        if ((base & 7) == 4) code.push_back(0x24);  // SIB of r12
+        if (small) code.push_back(uint8_t(offset)); else imm32(uint32_t(offset));
+    }
+
+    void mov(uint8_t r, uint64_t n) { bytes({ uint8_t(r < 8 ? 0x48 : 0x49), uint8_t(0xB8 + (r & 7)) }); imm64(n); }  // mov r, imm64
+    void load(uint8_t xmm, uint8_t r, int32_t offset) { code.push_back(0xF2); if (r >= 8) code.push_back(0x41); bytes({ 0x0F, 0x10 }); address(xmm, r, offset); }  // movsd xmm, [r+offset]
+    void store(uint8_t r, int32_t offset, uint8_t xmm) { code.push_back(0xF2); if (r >= 8) code.push_back(0x41); bytes({ 0x0F, 0x11 }); address(xmm, r, offset); }  // movsd [r+offset], xmm
+    void op(uint8_t prefix, uint8_t opcode, uint8_t xmm, uint8_t src) { bytes({ prefix, 0x0F, opcode, uint8_t(0xC0 | xmm << 3 | src) }); }  // op xmm, src
+    void call(uint8_t r, int32_t offset) { if (r >= 8) code.push_back(0x41); code.push_back(0xFF); address(2, r, offset); }  // call [r+offset]
+
+    std::vector<uint8_t> code;
+};
 
-void Square::print(std::ostream& out) const
+template <Expr::NodeType op> static double apply(double x, double y)
 {
-    if (f_x->is(NodeType::ADD) || f_x->is(NodeType::MUL)) out << "(";
-    f_x->print(out);
-    if (f_x->is(NodeType::ADD) || f_x->is(NodeType::MUL)) out << ")";
-    out << "^2";
+    return compute(op, x, y);
 }
 
-void XConic::print(std::ostream& out) const
+template <int n> static void applyTable(uint64_t* p)
 {
-    out << "xconic(";
-    f_x->print(out);
-    out << ")";
+    p[n] = reinterpret_cast<uint64_t>(&apply<Expr::NodeType(n)>);
+    applyTable<n - 1>(p);
 }
 
-void YConic::print(std::ostream& out) const
+template <> void applyTable<-1>(uint64_t*)
 {
-    out << "yconic(";
-    f_x->print(out);
-    out << ")";
 }
 
-void ZConic::print(std::ostream& out) const
-{
-    out << "zconic(";
-    f_x->print(out);
-    out << ")";
-}
+static int32_t const TABLE = 16;  // Entries ahead of 'r12', so that the first 32 have 8-bit offsets
 
-void Add::print(std::ostream& out) const
+static uint64_t const* nativeTable()  // 'apply<op>' at 'op', then the masks of 'abs' and 'neg', and 1.0
 {
-    f_x->print(out);
-    out << "+";
-    g_x->print(out);
+    static int const N = int(Expr::NodeType::POW) + 1;
+
+    static uint64_t const* const table = []
+    {
+        auto const p = new uint64_t[N + 3];  // Never destroyed, as the code of any CompiledExpression may refer to it
+        applyTable<N - 1>(p);
+        p[N] = ~0ULL >> 1;
+        p[N + 1] = ~(~0ULL >> 1);
+        p[N + 2] = 0x3FF0000000000000ULL;
+        return p;
+    }();
+
+    return table;
 }
 
-void Mul::print(std::ostream& out) const
+CompiledExpression::data::~data() noexcept
 {
-    if (f_x->is(NodeType::ADD) || f_x->is(NodeType::POW)) out << "(";
-    f_x->print(out);
-    if (f_x->is(NodeType::ADD) || f_x->is(NodeType::POW)) out << ")";
-    out << "*";
-    if (g_x->is(NodeType::ADD) || g_x->is(NodeType::POW)) out << "(";
-    g_x->print(out);
-    if (g_x->is(NodeType::ADD) || g_x->is(NodeType::POW)) out << ")";
+    for (auto& r : natives)
+    {
+#if defined(_WIN32)
+        VirtualFree(r.first, 0, MEM_RELEASE);
+#else
+        munmap(r.first, r.second);
+#endif
+    }
 }
 
-void Pow::print(std::ostream& out) const
+CompiledExpression::Function CompiledExpression::data::native(std::vector<Variable> const& parameters) const
 {
-    if (f_x->is(NodeType::ADD) || f_x->is(NodeType::MUL) || f_x->is(NodeType::POW)) out << "(";
-    f_x->print(out);
-    if (f_x->is(NodeType::ADD) || f_x->is(NodeType::MUL) || f_x->is(NodeType::POW)) out << ")";
-    out << "^";
-    if (g_x->is(NodeType::ADD) || g_x->is(NodeType::MUL) || g_x->is(NodeType::POW)) out << "(";
-    g_x->print(out);
-    if (g_x->is(NodeType::ADD) || g_x->is(NodeType::MUL) || g_x->is(NodeType::POW)) out << ")";
-}
+    // Machine code for 'run()' on the same registers: the variables are read from 'x[i]' if they are parameters and
+    // from their current values otherwise, then each instruction computes into xmm0 from xmm0 and xmm1.  The result of
+    // an instruction stays in xmm0 for the next one, and it is written to its register only if some other instruction
+    // reads it too; that is how the tape mostly chains.  The arithmetic is inlined and the rest calls 'compute()' via
+    // a table, so that the results are those of 'run()' to the bit.  NOTE: Like 'run()' the code is not reentrant, as
+    // it shares the registers.
 
-/***********************************************************************************************************************
-*** Expression
-***********************************************************************************************************************/
+    using E = Emitter;
 
-Expression::Expression() : pData(Shared::Clone(Nan::instance))
-{
-}
+#if defined(_WIN32)
+    auto const x = E::RCX;  // First argument in the Windows x64 calling convention
+#else
+    auto const x = E::RDI;  // First argument in the System V AMD64 calling convention
+#endif
 
-Expression::Expression(Expression const& r) : pData(Shared::Clone(r.pData))
-{
-}
+    static int32_t const ABSMASK = int32_t(NodeType::POW) + 1;
+    static int32_t const NEGMASK = ABSMASK + 1;
+    static int32_t const ONE = ABSMASK + 2;
 
-Expression::Expression(Variable const& r) : pData(data::variable(r))
-{
+    auto const entry = [](int32_t n) { return (n - TABLE) * 8; };
+    auto const slot = [](uint32_t n) { return int32_t(n * 8); };
+
+    std::vector<uint32_t> uses(registers.size());
+
+    for (auto& i : code)
+    {
+        ++uses[i.x];
+        if (i.op >= NodeType::ADD) ++uses[i.y];
+    }
+
+    uses[result] += 2;  // Read at the end
+
+    E a;
+
+    a.bytes({ 0x53, 0x41, 0x54 });  // push rbx, push r12
+    a.bytes({ 0x48, 0x83, 0xEC, 0x28 });  // sub rsp, 40: the shadow space of Windows, and the stack stays 16-aligned
+    a.mov(E::RBX, uint64_t(registers.data()));
+    a.mov(E::R12, uint64_t(nativeTable() + TABLE));
+
+    for (uint32_t i = 0; i < variables.size(); ++i)
+    {
+        auto const id = variables[i].id();
+        auto const item = std::find_if(parameters.begin(), parameters.end(), [id](Variable const& r) { return r.id() == id; });
+
+        if (item != parameters.end())
+        {
+            a.load(0, x, slot(uint32_t(item - parameters.begin())));
+        }
+        else
+        {
+            a.mov(E::RAX, uint64_t(&reinterpret_cast<Variable::data const*>(id)->value));
+            a.load(0, E::RAX, 0);  // NOTE: 'id()' is the address of the data, see 'Expression::data::dependency()'
+        }
+
+        a.store(E::RBX, slot(constants + i), 0);
+    }
+
+    auto z = uint32_t(constants + variables.size());
+    auto last = uint32_t(registers.size());  // Whose value is in xmm0, none at first
+
+    for (size_t k = 0; k < code.size(); ++k)
+    {
+        auto& i = code[k];
+        auto const binary = i.op >= NodeType::ADD;
+
+        if (binary && i.y == last) a.op(0x66, 0x28, 1, 0);  // movapd xmm1, xmm0
+        if (i.x != last) a.load(0, E::RBX, slot(i.x));
+        if (binary && i.y != last) a.load(1, E::RBX, slot(i.y));
+
+        switch (i.op)
+        {
+        case NodeType::ABS: a.load(1, E::R12, entry(ABSMASK)); a.op(0x66, 0x54, 0, 1); break;  // andpd with the mask
+        case NodeType::NEGATE: a.load(1, E::R12, entry(NEGMASK)); a.op(0x66, 0x57, 0, 1); break;  // xorpd with the sign
+        case NodeType::SQRT: a.op(0xF2, 0x51, 0, 0); break;  // sqrtsd
+        case NodeType::SQUARE: a.op(0xF2, 0x59, 0, 0); break;  // mulsd
+        case NodeType::INVERT: a.op(0x66, 0x28, 1, 0); a.load(0, E::R12, entry(ONE)); a.op(0xF2, 0x5E, 0, 1); break;  // 1.0 divsd
+        case NodeType::ADD: a.op(0xF2, 0x58, 0, 1); break;  // addsd
+
+        case NodeType::MUL:  // Both operands nonzero (or 'nan') mask the product, otherwise the result is 0 as in 'compute()'
+            a.op(0x66, 0x28, 2, 0);  // movapd xmm2, xmm0
+            a.op(0xF2, 0x59, 2, 1);  // mulsd xmm2, xmm1
+            a.op(0x66, 0x57, 3, 3);  // xorpd xmm3, xmm3
+            a.op(0xF2, 0xC2, 0, 3); a.bytes({ 4 });  // cmpneqsd xmm0, xmm3
+            a.op(0xF2, 0xC2, 1, 3); a.bytes({ 4 });  // cmpneqsd xmm1, xmm3
+            a.op(0x66, 0x54, 0, 1);  // andpd xmm0, xmm1
+            a.op(0x66, 0x54, 0, 2);  // andpd xmm0, xmm2
+            break;
+
+        case NodeType::SGN: case NodeType::CBRT: case NodeType::EXP: case NodeType::EXPM1: case NodeType::LOG: case NodeType::LOG1P:
+        case NodeType::SIN: case NodeType::COS: case NodeType::TAN: case NodeType::SEC: case NodeType::ASIN: case NodeType::ACOS:
+        case NodeType::ATAN: case NodeType::SINH: case NodeType::COSH: case NodeType::TANH: case NodeType::SECH: case NodeType::ASINH:
+        case NodeType::ACOSH: case NodeType::ATANH: case NodeType::ERF: case NodeType::ERFC: case NodeType::SOFTPP: case NodeType::SPENCE:
+        case NodeType::XCONIC: case NodeType::YCONIC: case NodeType::ZCONIC: case NodeType::POW:
+            a.call(E::R12, entry(int32_t(i.op)));  // 'apply<op>'
+            break;
+
+        default:
+            a.call(E::R12, entry(int32_t(NodeType::CONSTANT)));  // 'nan' as in 'run()'
+            break;
+        }
+
+        auto const next = k + 1 < code.size() ? &code[k + 1] : nullptr;
+        auto const chained = uses[z] == 1 && next && (next->x == z || (next->op >= NodeType::ADD && next->y == z));
+
+        if (!chained) a.store(E::RBX, slot(z), 0);
+        last = z++;
+    }
+
+    if (result != last) a.load(0, E::RBX, slot(result));
+    a.bytes({ 0x48, 0x83, 0xC4, 0x28 });  // add rsp, 40
+    a.bytes({ 0x41, 0x5C, 0x5B, 0xC3 });  // pop r12, pop rbx, ret
+
+    // Written while writable, then made executable instead
+
+    auto const n = a.code.size();
+
+#if defined(_WIN32)
+    auto p = VirtualAlloc(nullptr, n, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    assert(p);
+    std::copy(a.code.begin(), a.code.end(), static_cast<uint8_t*>(p));
+    DWORD was;
+    VirtualProtect(p, n, PAGE_EXECUTE_READ, &was);
+#else
+    auto p = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(p != MAP_FAILED);
+    std::copy(a.code.begin(), a.code.end(), static_cast<uint8_t*>(p));
+    mprotect(p, n, PROT_READ | PROT_EXEC);
+#endif
+
+    natives.emplace_back(p, n);
+
+    return reinterpret_cast<Function>(p);
 }
 
-Expression::Expression(double d) : pData(data::constant(d))
+#endif
+
+/***********************************************************************************************************************
+*** CompiledExpression
+***********************************************************************************************************************/
+
+CompiledExpression::CompiledExpression(Expression const& r) : pData(new data(r.pData))
 {
 }
 
-Expression::Expression(int i) : pData(data::constant(i))
+CompiledExpression::CompiledExpression(CompiledExpression const& r) noexcept : pData(Shared::Clone(r.pData))
 {
 }
 
-Expression::Expression(data const* p) : pData(p)
+CompiledExpression::CompiledExpression(data const* p) : pData(p)
 {
 }
 
-Expression::~Expression()
+CompiledExpression::~CompiledExpression() noexcept
 {
     Shared::Erase(pData);
 }
 
-Expression& Expression::operator=(Expression const& r) noexcept
+CompiledExpression& CompiledExpression::operator=(CompiledExpression const& r) noexcept
 {
     Shared::Clone(r.pData);
     Shared::Erase(pData);
@@ -3921,310 +7131,270 @@ Expression& Expression::operator=(Expression const& r) noexcept
     return *this;
 }
 
-//----------------------------------------------------------------------------------------------------------------------
-
-Expression abs(Expression const& r)
-{
-    return r.pData->abs();
-}
-
-Expression sgn(Expression const& r)
-{
-    return r.pData->sgn();
-}
-
-Expression sqrt(Expression const& r)
+double CompiledExpression::operator()() const
 {
-    return r.pData->sqrt();
+    return pData->run();
 }
 
-Expression cbrt(Expression const& r)
+double CompiledExpression::Evaluate() const
 {
-    return r.pData->cbrt();
+    return pData->run();
 }
 
-Expression exp(Expression const& r)
+std::vector<double> CompiledExpression::Evaluate(std::vector<std::pair<Variable, std::vector<double>>> const& r) const
 {
-    return r.pData->exp();
+    return pData->batch(r);
 }
 
-Expression expm1(Expression const& r)
+double CompiledExpression::EvaluateGradient(std::vector<Variable> const& v, double* out) const
 {
-    return r.pData->expm1();
+    return pData->gradient(v, out);
 }
 
-Expression log(Expression const& r)
+std::pair<double, double> CompiledExpression::EvaluateDirectional(std::vector<std::pair<Variable, double>> const& d) const
 {
-    return r.pData->log();
-}
+    std::vector<std::pair<Variable, std::vector<double>>> lanes;
+    for (auto& item : d) lanes.emplace_back(item.first, std::vector<double>{ item.second });
 
-Expression log1p(Expression const& r)
-{
-    return r.pData->log1p();
+    double tangent = 0;  // Stays so for an empty direction
+    auto const value = pData->directional(lanes, &tangent);
+    return { value, tangent };
 }
 
-Expression sin(Expression const& r)
+double CompiledExpression::EvaluateDirectional(std::vector<std::pair<Variable, std::vector<double>>> const& d, double* out) const
 {
-    return r.pData->sin();
+    return pData->directional(d, out);
 }
 
-Expression cos(Expression const& r)
+CompiledExpression CompiledExpression::Derive(Variable const& r) const
 {
-    return r.pData->cos();
+    return new data(*pData, r);
 }
 
-Expression tan(Expression const& r)
-{
-    return r.pData->tan();
-}
+#if defined(LASKENTA_THREADS)
 
-Expression asin(Expression const& r)
+double CompiledExpression::EvaluateParallel() const
 {
-    return r.pData->asin();
+    return pData->parallel();
 }
 
-Expression acos(Expression const& r)
-{
-    return r.pData->acos();
-}
+#endif
 
-Expression atan(Expression const& r)
-{
-    return r.pData->atan();
-}
+#if defined(LASKENTA_JIT)
 
-Expression sinh(Expression const& r)
+CompiledExpression::Function CompiledExpression::Native(std::vector<Variable> const& parameters) const
 {
-    return r.pData->sinh();
+    return pData->native(parameters);
 }
 
-Expression cosh(Expression const& r)
-{
-    return r.pData->cosh();
-}
+#endif
 
-Expression tanh(Expression const& r)
+CompiledExpression Expression::Compile() const
 {
-    return r.pData->tanh();
+    return *this;
 }
 
-Expression asinh(Expression const& r)
+std::string Expression::Source(std::string const& name, std::vector<Variable> const& parameters) const
 {
-    return r.pData->asinh();
+    return CompiledExpression::data::source({ pData }, name, parameters, false);
 }
 
-Expression acosh(Expression const& r)
+std::string Expression::Source(std::vector<Expression> const& r, std::string const& name, std::vector<Variable> const& parameters)
 {
-    return r.pData->acosh();
-}
+    std::vector<Expr const*> roots;
+    for (auto& x : r) roots.push_back(x.pData);
 
-Expression atanh(Expression const& r)
-{
-    return r.pData->atanh();
+    return CompiledExpression::data::source(roots, name, parameters, true);
 }
 
-Expression erf(Expression const& r)
+std::vector<double> Expression::Evaluate(std::vector<std::pair<Variable, std::vector<double>>> const& r) const
 {
-    return r.pData->erf();
+    return CompiledExpression(*this).Evaluate(r);
 }
 
-Expression erfc(Expression const& r)
+double Expression::EvaluateGradient(std::vector<Variable> const& v, double* out) const
 {
-    return r.pData->erfc();
+    return CompiledExpression(*this).EvaluateGradient(v, out);
 }
 
-Expression Li2(Expression const& r)
+std::pair<double, double> Expression::EvaluateDirectional(std::vector<std::pair<Variable, double>> const& d) const
 {
-    return r.pData->spence();
+    return CompiledExpression(*this).EvaluateDirectional(d);
 }
 
-Expression Spp(Expression const& r)
+double Expression::EvaluateDirectional(std::vector<std::pair<Variable, std::vector<double>>> const& d, double* out) const
 {
-    return r.pData->softpp();
+    return CompiledExpression(*this).EvaluateDirectional(d, out);
 }
 
-Expression operator+(Expression const& r)
-{
-    return r;
-}
+/***********************************************************************************************************************
+*** EvaluationContext
+***********************************************************************************************************************/
 
-Expression operator-(Expression const& r)
+struct EvaluationContext::data final : public Shared
 {
-    return r.pData->negate();
-}
+    // Only the constants are copied from the shared registers, the others may be being written by another thread
 
-Expression operator+(Expression const& r, Expression const& s)
-{
-    return r.pData->add(s.pData);
-}
+    explicit data(CompiledExpression::data const* p) : compiled(Shared::Clone(p)), registers(p->registers.begin(), p->registers.begin() + p->constants), clean(false)
+    {
+        for (auto& v : p->variables) registers.push_back(v());
 
-Expression operator-(Expression const& r, Expression const& s)
-{
-    // f_x-g_x = f_x + -g_x
+        registers.resize(p->registers.size());
+        adjoints.resize(p->registers.size());
+    }
 
-    auto step0 = s.pData->negate();
-    auto step1 = r.pData->add(step0);
+    ~data() { Shared::Erase(compiled); }
 
-    Shared::Erase(step0);
+    CompiledExpression::data const* const compiled;  // Not written by the context
+    mutable std::vector<double> registers;  // Laid out like those of 'compiled'
+    mutable std::vector<double> adjoints;
+    mutable bool clean;  // The registers of the instructions are up to date with those of the variables
 
-    return step1;
-}
+    data(data const&) = delete;
+};
 
-Expression operator*(Expression const& r, Expression const& s)
-{
-    return r.pData->mul(s.pData);
-}
+//----------------------------------------------------------------------------------------------------------------------
 
-Expression operator/(Expression const& r, Expression const& s)
+EvaluationContext::EvaluationContext(CompiledExpression const& r) : pData(new data(r.pData))
 {
-    // f_x/g_x = f_x * 1/g_x
-
-    auto step0 = s.pData->invert();
-    auto step1 = r.pData->mul(step0);
-
-    Shared::Erase(step0);
-
-    return step1;
 }
 
-double Expression::operator()() const noexcept
+EvaluationContext::EvaluationContext(EvaluationContext const& r) noexcept : pData(Shared::Clone(r.pData))
 {
-    return pData->evaluate();
 }
 
-Expression::operator double() const
+EvaluationContext::~EvaluationContext() noexcept
 {
-    return pData->evaluate();
+    Shared::Erase(pData);
 }
 
-Expression pow(Expression const& r, Expression const& s)
+EvaluationContext& EvaluationContext::operator=(EvaluationContext const& r) noexcept
 {
-    return r.pData->pow(s.pData);
+    Shared::Clone(r.pData);
+    Shared::Erase(pData);
+    pData = r.pData;
+    return *this;
 }
 
-void AtomicAssign(Bindings& r)
+void EvaluationContext::Assign(Variable const& x, double d)
 {
-    auto const N = r.size();
-    double* p = new double[N];
-
-    for (int i = 0; i < N; ++i) p[i] = r[i].second();
-    for (int i = 0; i < N; ++i) r[i].first = p[i];
-
-    delete[] p;
-}
+    assert(!isinf(d));
+    assert(!isnan(d));
+    assert(x.Range().first <= d && d <= x.Range().second);  // The simplifications may have relied on the range
 
-Expression Expression::AtomicBind(Bindings const& r) const
-{
-    std::vector<std::pair<Variable, Expression::data const*> > t;
-    for (auto& s : r) t.emplace_back(s.first, s.second.pData);
-    return pData->bind(t);
-}
+    auto const& index = pData->compiled->index;
+    auto const p = index.find(x.id());
 
-Expression Expression::Bind(Variable const& r, double d) const
-{
-    Expression s(d);
-    std::vector<std::pair<Variable, Expression::data const*>> t;
-    t.emplace_back(r, s.pData);
-    return pData->bind(t);
-}
+    if (p == index.end() || pData->registers[p->second] == d) return;  // The value does not matter, or is already there
 
-Expression Expression::Derive(Variable const& r) const
-{
-    auto result = pData->derive(r);
-    pData->purge();
-    return result;
+    pData->registers[p->second] = d;
+    pData->clean = false;
 }
 
-double Expression::Evaluate() const
+double EvaluationContext::Value(Variable const& x) const
 {
-    return pData->evaluate();
-}
+    auto const& index = pData->compiled->index;
+    auto const p = index.find(x.id());
 
-bool Expression::Guaranteed(Attribute a) const
-{
-    return pData->guaranteed(a);
+    return p != index.end() ? pData->registers[p->second] : x();
 }
 
-void Expression::Touch()
+double EvaluationContext::Evaluate()
 {
-    ++Expr::dirtyLevel;
-}
+    if (!pData->clean) pData->compiled->run(pData->registers.data());
+    pData->clean = true;
 
-int32_t Expression::Depth() const noexcept
-{
-    return pData->depth;
+    return pData->registers[pData->compiled->result];
 }
 
-std::ostream& operator<<(std::ostream& r, Expression const& s)
+double EvaluationContext::EvaluateGradient(std::vector<Variable> const& v, double* out)
 {
-    s.pData->print(r);
-    return r;
+    auto const value = Evaluate();
+    pData->compiled->sweep(pData->registers.data(), pData->adjoints.data(), v, out);
+    return value;
 }
 
 /***********************************************************************************************************************
-*** Variable::data
+*** ExpressionGroup
 ***********************************************************************************************************************/
 
-struct Variable::data : public Shared
+struct ExpressionGroup::data final : public CompiledExpression::data
 {
-    data(double d) : value(d), name("[&" + std::to_string(size_t(this) / sizeof(*this)) + "]") { }
+    data(std::vector<Expr const*> const& r, std::vector<Variable> const& v) : CompiledExpression::data(r), targets(v) { }
 
-    mutable double value;
-    mutable std::string name;
+    mutable std::vector<Variable> targets;  // Of 'AtomicAssign()', if the group was made of bindings
 };
 
-/***********************************************************************************************************************
-*** Variable
-***********************************************************************************************************************/
+//----------------------------------------------------------------------------------------------------------------------
 
-Variable::Variable(double d) : pData(new data(d))
+ExpressionGroup::ExpressionGroup(std::vector<Expression> const& r) : pData(nullptr)
 {
+    std::vector<Expr const*> expressions;
+    for (auto& x : r) expressions.push_back(x.pData);
+
+    pData = new data(expressions, {});
 }
 
-Variable::Variable(Variable const& r) noexcept : pData(Shared::Clone(r.pData))
+ExpressionGroup::ExpressionGroup(Bindings const& r) : pData(nullptr)
+{
+    std::vector<Expr const*> expressions;
+    std::vector<Variable> variables;
+
+    for (auto& item : r)
+    {
+        expressions.push_back(item.second.pData);
+        variables.push_back(item.first);
+    }
+
+    pData = new data(expressions, variables);
+}
+
+ExpressionGroup::ExpressionGroup(ExpressionGroup const& r) noexcept : pData(Shared::Clone(r.pData))
 {
 }
 
-Variable::~Variable() noexcept
+ExpressionGroup::~ExpressionGroup() noexcept
 {
     Shared::Erase(pData);
 }
 
-Variable& Variable::operator=(double d)
+ExpressionGroup& ExpressionGroup::operator=(ExpressionGroup const& r) noexcept
 {
-    assert(!isinf(d));
-    assert(!isnan(d));
-
-    pData->value = d;
-
-    Expression::Touch();
-
+    Shared::Clone(r.pData);
+    Shared::Erase(pData);
+    pData = r.pData;
     return *this;
 }
 
-Variable::operator double() const noexcept
+size_t ExpressionGroup::Size() const
 {
-    return pData->value;
+    return pData->results.size();
 }
 
-double Variable::operator()() const noexcept
+void ExpressionGroup::Evaluate(double* out) const
 {
-    return pData->value;
-}
+    if (pData->results.empty()) return;
 
-std::string Variable::Name() const
-{
-    return pData->name;
+    pData->run();
+    for (auto n : pData->results) *out++ = pData->registers[n];
 }
 
-void Variable::Name(std::string const& s)
+std::vector<double> ExpressionGroup::Evaluate() const
 {
-    pData->name = s;
+    std::vector<double> result(Size());
+    Evaluate(result.data());
+    return result;
 }
 
-size_t Variable::id() const
+void AtomicAssign(ExpressionGroup const& r)
 {
-    return size_t(pData);
+    // All the values are computed before any of the variables is assigned
+
+    auto& targets = r.pData->targets;
+    assert(targets.size() == r.Size());
+
+    auto const values = r.Evaluate();
+    for (size_t i = 0; i < values.size(); ++i) targets[i] = values[i];
 }
 
 /***********************************************************************************************************************
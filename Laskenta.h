@@ -28,6 +28,9 @@ SOFTWARE.
 #include <string>
 #include <vector>
 
+// #define LASKENTA_JIT  // x86-64 machine code by 'CompiledExpression::Native()'
+// #define LASKENTA_THREADS  // Expressions may be constructed, bound and derived by several threads at once, see also 'EvaluationContext'
+
 //**********************************************************************************************************************
 
 using Bindings = std::vector<std::pair<struct Variable, struct Expression>>;
@@ -39,6 +42,7 @@ using Bindings = std::vector<std::pair<struct Variable, struct Expression>>;
 struct Variable final
 {
     Variable(double = 0);
+    Variable(double, double, double);  // Value and the range of the values, [lo, hi]
     Variable(Variable const&) noexcept;
     ~Variable() noexcept;
 
@@ -48,6 +52,7 @@ struct Variable final
 
     struct data;
     size_t id() const;
+    std::pair<double, double> Range() const;
     std::string Name() const;
     void Name(std::string const&);
 
@@ -120,9 +125,19 @@ struct Expression final
     friend void AtomicAssign(Bindings&);
     Expression AtomicBind(Bindings const&) const;
     Expression Bind(Variable const&, double) const;
+    std::vector<Expression> BindMany(Variable const&, std::vector<double> const&) const;
+    struct CompiledExpression Compile() const;
     Expression Derive(Variable const&) const;
     double Evaluate() const;
+    std::vector<double> Evaluate(std::vector<std::pair<Variable, std::vector<double>>> const&) const;
+    double EvaluateGradient(std::vector<Variable> const&, double*) const;
+    std::pair<double, double> EvaluateDirectional(std::vector<std::pair<Variable, double>> const&) const;  // Value and derivative along the direction
+    double EvaluateDirectional(std::vector<std::pair<Variable, std::vector<double>>> const&, double*) const;  // One derivative per direction to 'out'
+    std::vector<Expression> Gradient(std::vector<Variable> const&) const;  // 'Derive()' of each, up to rounding: the adjoints group the terms differently
     bool Guaranteed(Attribute) const;
+    std::pair<double, double> Range() const;  // Bounds of the values, from the ranges of the variables
+    std::string Source(std::string const&, std::vector<Variable> const&) const;  // C++ function 'double name(double const* x)'
+    static std::string Source(std::vector<Expression> const&, std::string const&, std::vector<Variable> const&);  // 'void name(double const* x, double* y)'
     static void Touch();
 
     struct data;
@@ -134,6 +149,95 @@ private:
     friend int main();
 
     int32_t Depth() const noexcept;
+
+    friend struct CompiledExpression;
+    friend struct ExpressionGroup;
+};
+
+/***********************************************************************************************************************
+*** CompiledExpression
+***********************************************************************************************************************/
+
+struct CompiledExpression final
+{
+    CompiledExpression(Expression const&);
+    CompiledExpression(CompiledExpression const&) noexcept;
+    ~CompiledExpression() noexcept;
+
+    CompiledExpression& operator=(CompiledExpression const&) noexcept;
+
+    double operator()() const;
+    CompiledExpression Derive(Variable const&) const;
+    double Evaluate() const;  // As 'Expression::Evaluate()', but a product that underflows to 0 also prunes its remaining factors
+    std::vector<double> Evaluate(std::vector<std::pair<Variable, std::vector<double>>> const&) const;
+    double EvaluateGradient(std::vector<Variable> const&, double*) const;
+    std::pair<double, double> EvaluateDirectional(std::vector<std::pair<Variable, double>> const&) const;
+    double EvaluateDirectional(std::vector<std::pair<Variable, std::vector<double>>> const&, double*) const;
+
+#if defined(LASKENTA_THREADS)
+    double EvaluateParallel() const;  // Same as 'Evaluate()', the independent subexpressions on several threads
+#endif
+
+#if defined(LASKENTA_JIT)
+    using Function = double (*)(double const*);  // Valid while the CompiledExpression exists, but not reentrant; faster than 'Evaluate()' while it fits in the caches
+    Function Native(std::vector<Variable> const&) const;  // Reads 'x[i]' for the listed Variables, the others as they are
+#endif
+
+    struct data;
+
+private:
+    CompiledExpression(data const*);
+    data const* pData;
+
+    friend struct EvaluationContext;
+};
+
+/***********************************************************************************************************************
+*** ExpressionGroup
+***********************************************************************************************************************/
+
+struct ExpressionGroup final  // Expressions compiled together, so that their common nodes are evaluated once for all
+{
+    ExpressionGroup(std::vector<Expression> const&);
+    ExpressionGroup(Bindings const&);  // The bound expressions, assigned to the variables by 'AtomicAssign()'
+    ExpressionGroup(ExpressionGroup const&) noexcept;
+    ~ExpressionGroup() noexcept;
+
+    ExpressionGroup& operator=(ExpressionGroup const&) noexcept;
+
+    friend void AtomicAssign(ExpressionGroup const&);
+
+    size_t Size() const;
+    void Evaluate(double*) const;  // 'Size()' values, in the order of the expressions
+    std::vector<double> Evaluate() const;
+
+    struct data;
+
+private:
+    data const* pData;
+};
+
+/***********************************************************************************************************************
+*** EvaluationContext
+***********************************************************************************************************************/
+
+struct EvaluationContext final  // Values of the variables and registers of its own, so that threads can share a CompiledExpression
+{
+    EvaluationContext(CompiledExpression const&);  // The variables have their current values.  Without LASKENTA_THREADS create it before the threads
+    EvaluationContext(EvaluationContext const&) noexcept;  // The same context, as copies of a CompiledExpression share its registers
+    ~EvaluationContext() noexcept;
+
+    EvaluationContext& operator=(EvaluationContext const&) noexcept;
+
+    void Assign(Variable const&, double);  // In this context only, the Variable itself keeps its value
+    double Value(Variable const&) const;
+    double Evaluate();
+    double EvaluateGradient(std::vector<Variable> const&, double*);
+
+    struct data;
+
+private:
+    data const* pData;
 };
 
 //**********************************************************************************************************************
@@ -165,6 +269,9 @@ inline Expression exp2(Expression const& x) { return exp(x * log(2)); }
 inline Expression log2(Expression const& x) { return log(x) / log(2); }
 inline Expression log10(Expression const& x) { return log(x) / log(10); }
 
+Expression Sum(std::vector<Expression>);  // Balanced sum
+Expression Mean(std::vector<Expression> const&);
+
 //**********************************************************************************************************************
 
 inline double sgn(double x) { return double(x > 0) - double(x < 0); }
@@ -28,6 +28,11 @@ SOFTWARE.
 #include <assert.h>
 #include <iostream>
 #include <type_traits>
+#include <vector>
+
+#if defined(LASKENTA_THREADS)
+#include <atomic>
+#endif
 
 //**********************************************************************************************************************
 
@@ -40,6 +45,11 @@ SOFTWARE.
 #else
 #define WARN(why) do { static auto f=__FUNCTION__; static auto l=__LINE__; static struct S { ~S() { std::cerr << "WARNING: " why " in function '" << f << "(...)' line " << l << "." << std::endl; } } s; } while (false)
 #endif
+#if defined(_MSC_VER)
+#define FORCEINLINE __forceinline
+#else
+#define FORCEINLINE inline __attribute__((always_inline))
+#endif
 
 /***********************************************************************************************************************
 *** Shared
@@ -51,7 +61,16 @@ struct Shared
 	template <typename T, typename = typename std::enable_if<std::is_base_of<Shared, T>::value>::type> static inline T const* Clone(T const& r) noexcept { ++r.nShared; return &r; }
 	template <typename T, typename = typename std::enable_if<std::is_base_of<Shared, T>::value>::type> static inline T* Clone(T* p) noexcept { if (p) ++p->nShared; return p; }
 	template <typename T, typename = typename std::enable_if<std::is_base_of<Shared, T>::value>::type> static inline T* Clone(T& r) noexcept { ++r.nShared; return &r; }
-	static inline void Erase(Shared const* p) noexcept { if (p && !--p->nShared) delete p; }
+	static inline void Erase(Shared const* p) noexcept { if (p && !--p->nShared) Delete(p); }
+
+#if defined(LASKENTA_THREADS)
+	template <typename T> static inline T const* CloneLive(T const* p) noexcept  // nullptr if another thread is already deleting the object
+	{
+		auto n = p->nShared.load();
+		do if (!n) return nullptr; while (!p->nShared.compare_exchange_weak(n, n + 1));
+		return p;
+	}
+#endif
 
 protected:
 	Shared() noexcept : nShared(1) { }
@@ -61,7 +80,13 @@ protected:
 	bool IsShared() const noexcept { return nShared > 1; }
 
 private:
+#if defined(LASKENTA_THREADS)
+	mutable std::atomic<size_t> nShared;
+#else
 	mutable size_t nShared;
+#endif
+
+	static void Delete(Shared const*) noexcept;
 
 	Shared(Shared&&) = delete;
 	Shared& operator=(Shared&&) = delete;
@@ -73,6 +98,48 @@ inline Shared::~Shared()
 	assert(!IsShared());
 }
 
+inline void Shared::Delete(Shared const* p) noexcept
+{
+	// A destructor that erases the objects it refers to would recurse once per object in a chain of them.  Instead the
+	// objects released while another one is being deleted are queued, and deleted one at a time by the outermost call.
+	// NOTE: The queue is never destroyed, so that objects can be erased during the destruction of static objects.  With
+	// several threads each one has a queue of its own that is destroyed with the thread.  The objects that the thread
+	// releases after that are deleted recursively, as the main thread does while the static objects are destroyed.
+
+#if defined(LASKENTA_THREADS)
+	static thread_local bool finished = false;
+	static thread_local struct Queue : std::vector<Shared const*> { ~Queue() { finished = true; } } pending;
+	static thread_local bool deleting = false;
+
+	if (finished)
+	{
+		delete p;
+		return;
+	}
+#else
+	static auto& pending = *new std::vector<Shared const*>;
+	static bool deleting = false;
+#endif
+
+	if (deleting)
+	{
+		pending.push_back(p);
+		return;
+	}
+
+	deleting = true;
+	delete p;
+
+	while (!pending.empty())
+	{
+		p = pending.back();
+		pending.pop_back();
+		delete p;
+	}
+
+	deleting = false;
+}
+
 /***********************************************************************************************************************
 *** Saved
 ***********************************************************************************************************************/
@@ -0,0 +1,127 @@
+
+#include "Laskenta.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using std::cout;
+using std::endl;
+
+//**********************************************************************************************************************
+
+// Bind() and AtomicBind() on the training graph of 'main.cpp', and on a graph where every node is reached by a number
+// of paths that doubles per level.  Only the API that precedes the memoized bind is used, so that the same program can
+// be built before and after it for a comparison.
+
+static size_t const N = 85;  // Same network as in 'main.cpp'
+
+static int const LEVELS = 22;  // Of the doubling graph; each level doubles the paths to the nodes below it
+
+double Seconds(std::chrono::steady_clock::time_point const& since)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+//**********************************************************************************************************************
+
+int main() try
+{
+    cout << std::setprecision(6);
+
+    Variable x;
+    Variable gain_0[N];
+    Variable bias_0[N];
+    Variable gain_1[N];
+    Variable bias_1;
+    Variable rate;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        gain_0[i] = sin(i);
+        gain_1[i] = cos(i);
+    }
+
+    Expression output = x * bias_1;
+
+    for (size_t i = 0; i < N; ++i) output = output + gain_1[i] * sinh(bias_0[i] + gain_0[i] * x);
+
+    Expression X = x;
+    Expression computation = output.Derive(x);
+    Expression expectation = (X * X - 1) * (X * X - 1) / (X * X + 1);
+    Expression loss = (computation - expectation) * (computation - expectation);
+
+    //**********************************************************************************************************************
+
+    cout << endl << "-------------- Training graph of 'main.cpp':" << endl << endl;
+
+    auto start = std::chrono::steady_clock::now();
+
+    Expression batch = 0;
+
+    for (int i = 0; i <= 180; ++i) batch = batch + loss.Bind(x, (i - 90.0) / 90.0);
+
+    batch = batch / 181;
+
+    cout << "181 x Bind: " << Seconds(start) << " s" << endl;
+
+    std::vector<Variable> weights;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        weights.push_back(gain_0[i]);
+        weights.push_back(bias_0[i]);
+        weights.push_back(gain_1[i]);
+    }
+    weights.push_back(bias_1);
+
+    auto gradient = batch.Gradient(weights);
+
+    Bindings gradients;
+
+    for (size_t i = 0; i < weights.size(); ++i) gradients.emplace_back(weights[i], weights[i] - rate * gradient[i]);
+
+    start = std::chrono::steady_clock::now();
+
+    batch = batch.AtomicBind(gradients);
+
+    cout << "AtomicBind: " << Seconds(start) << " s" << endl;
+
+    //**********************************************************************************************************************
+
+    cout << endl << "-------------- Shared subgraphs:" << endl << endl;
+
+    Variable v;
+    Expression e = v;
+
+    for (int i = 0; i < LEVELS; ++i) e = sin(e) * cos(e);  // <---- Both factors share 'e', so the paths double
+
+    start = std::chrono::steady_clock::now();
+
+    Expression bound = e.Bind(v, 0.5);
+
+    cout << LEVELS << " levels, Bind: " << Seconds(start) << " s" << endl;
+
+    v = 0.5;
+
+    cout << "Bound " << bound.Evaluate() << ", evaluated " << e.Evaluate() << endl;
+
+    //**********************************************************************************************************************
+
+    return EXIT_SUCCESS;
+}
+catch (std::exception e)
+{
+    cout << endl << e.what() << endl << endl;
+}
+catch (char const* p)
+{
+    cout << endl << p << endl << endl;
+}
+catch (...)
+{
+    cout << endl << "Diva tantrum!!!!" << endl << endl;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
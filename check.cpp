@@ -0,0 +1,281 @@
+
+#include "Laskenta.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::endl;
+
+//**********************************************************************************************************************
+
+static int failures = 0;
+
+static void Check(std::string const& what, bool ok)
+{
+    cout << (ok ? "ok      " : "FAILED  ") << what << endl;
+    if (!ok) ++failures;
+}
+
+static std::string Print(Expression const& e)
+{
+    std::ostringstream out;
+    out << e;
+    return out.str();
+}
+
+//**********************************************************************************************************************
+
+int main() try
+{
+    cout << std::setprecision(17);
+
+    Variable a(1);
+    Variable b(-5);
+    Variable c(4);
+    Variable x(3);
+
+    a.Name("a");
+    b.Name("b");
+    c.Name("c");
+    x.Name("x");
+
+    Expression quadratic = a * x * x + b * x + c;
+
+    //**********************************************************************************************************************
+
+    cout << endl << "-------------- Derivatives are remembered across Derive() calls:" << endl << endl;
+
+    {
+        Expression first = quadratic.Derive(x);
+        Expression again = quadratic.Derive(x);
+
+        Check("F'(x) = " + Print(first) + " twice", Print(first) == Print(again));
+        Check("F'(x) = 2*a*x+b at x = 3", first.Evaluate() == 1);
+        Check("F'(a) = x*x after F'(x)", quadratic.Derive(a).Evaluate() == 9);
+        Check("F'(b) = x", quadratic.Derive(b).Evaluate() == 3);
+        Check("F'(c) = 1", quadratic.Derive(c).Evaluate() == 1);
+        Check("F''(x) = 2*a", quadratic.Derive(x).Derive(x).Evaluate() == 2);
+        Check("F'''(x) = 0", quadratic.Derive(x).Derive(x).Derive(x).Evaluate() == 0);
+        Check("(F'(x))'(a) = 2*x", quadratic.Derive(x).Derive(a).Evaluate() == 6);
+    }
+
+    {
+        x = 4;
+
+        {
+            Expression root = a * sqrt(quadratic + x);  // <---- sqrt((x-2)^2)
+            Check("D(a*sqrt(F+x)) = 1 at x = 4", root.Derive(x).Evaluate() == 1);
+        }
+
+        x = 6;
+        Expression root = a * sqrt(quadratic + x);  // <---- Built anew after the first one was released with its derivatives
+        Check("D(a*sqrt(F+x)) = 1 at x = 6, built anew", root.Derive(x).Evaluate() == 1);
+        x = 3;
+    }
+
+    {
+        Expression g = sin(quadratic) * exp(quadratic);
+        double const f = -2;  // F(3)
+        double const expected = (std::cos(f) * std::exp(f) + std::sin(f) * std::exp(f)) * 1;
+        Check("G'(x) of G = sin(F)*exp(F) after F'(x)", std::abs(g.Derive(x).Evaluate() - expected) <= 1e-12 * std::abs(expected));
+    }
+
+    //**********************************************************************************************************************
+
+    cout << endl << "-------------- Attributes are inferred once per node:" << endl << endl;
+
+    {
+        using Attribute = Expression::Attribute;
+
+        Expression X = x;
+
+        Check("exp(x) is positive", exp(X).Guaranteed(Attribute::POSITIVE));
+        Check("x is not known to be positive", !X.Guaranteed(Attribute::POSITIVE));
+        Check("x*x is nonnegative", (X * X).Guaranteed(Attribute::NONNEGATIVE));
+        Check("-exp(x) is negative", (-exp(X)).Guaranteed(Attribute::NEGATIVE));
+        Check("tanh(x) is within (-1, 1)", tanh(X).Guaranteed(Attribute::OPENUNITRANGE));
+        Check("sin(x) is within [-1, 1]", sin(X).Guaranteed(Attribute::UNITRANGE));
+        Check("log(x) is not defined everywhere", !log(X).Guaranteed(Attribute::DEFINED));
+        Check("log(x) asked again", !log(X).Guaranteed(Attribute::DEFINED));
+
+        Expression e = x;
+
+        for (int i = 0; i < 200; ++i) e = e * e + exp(e);  // <---- Each level reaches the one below by more than one path
+
+        Check("200 levels of e*e+exp(e) are positive", e.Guaranteed(Attribute::POSITIVE));
+        Check("... and asked again", e.Guaranteed(Attribute::POSITIVE));
+        Check("... and not negative", !e.Guaranteed(Attribute::NEGATIVE));
+
+        Variable y(0.5);
+        Expression chain = y;
+
+        for (int i = 0; i < 1000000; ++i) chain = sin(chain) * 0.999 + y;  // <---- Deeper than the call stack could recurse
+
+        Check("1000000 levels of sin(e)*0.999+y are defined", chain.Guaranteed(Attribute::DEFINED));
+        Check("... and not known to be nonnegative", !chain.Guaranteed(Attribute::NONNEGATIVE));
+        Check("... and abs() of them is", abs(chain).Guaranteed(Attribute::NONNEGATIVE));
+        Check("... as is sqrt() of their square", sqrt(chain * chain).Guaranteed(Attribute::NONNEGATIVE));
+    }
+
+    //**********************************************************************************************************************
+
+    cout << endl << "-------------- Ranges follow from the declared ranges of the variables:" << endl << endl;
+
+    {
+        using Attribute = Expression::Attribute;
+
+        Variable p(1, 0.5, 3);  // <---- Value 1 within [0.5, 3]
+        Variable q(0, -2, 1);
+
+        p.Name("p");
+        q.Name("q");
+
+        Expression P = p;
+        Expression Q = q;
+
+        std::vector<Expression> expressions = { P * Q + sin(Q), exp(Q) / P, sqrt(P) - Q * Q, log(P) * cos(P * Q), atan(Q) + tanh(P), pow(P, Q) };
+
+        for (auto& e : expressions)
+        {
+            auto const range = e.Range();
+            auto contained = range.first <= range.second;
+
+            for (int i = 0; i <= 40; ++i) for (int j = 0; j <= 40; ++j)
+            {
+                p = 0.5 + i * (3 - 0.5) / 40;
+                q = -2 + j * (1 + 2) / 40.0;
+
+                auto const value = e.Evaluate();
+                contained = contained && range.first <= value && value <= range.second;
+            }
+
+            std::ostringstream what;
+            what << Print(e) << " within [" << range.first << ", " << range.second << "] on a 41x41 grid";
+            Check(what.str(), contained);
+        }
+
+        p = 1;
+        q = 0;
+
+        Check("sqrt(p) is positive", sqrt(P).Guaranteed(Attribute::POSITIVE));
+        Check("log(p-0.25) is defined", log(P - 0.25).Guaranteed(Attribute::DEFINED));
+        Check("exp(q)/p is bounded above", (exp(Q) / P).Guaranteed(Attribute::BOUNDEDABOVE));
+        Check("p*q+sin(q) is not known to be positive", !(P * Q + sin(Q)).Guaranteed(Attribute::POSITIVE));
+    }
+
+    //**********************************************************************************************************************
+
+    cout << endl << "-------------- Evaluation contexts keep the values of their own:" << endl << endl;
+
+    {
+        CompiledExpression compiled(quadratic);
+        EvaluationContext context(compiled);
+        EvaluationContext copy = context;
+
+        context.Assign(x, 5);
+
+        Check("F(5) = 4 in the context", context.Evaluate() == 4);
+        Check("F(3) = -2 by the Variable", x() == 3 && compiled.Evaluate() == -2);
+        Check("A copy is the same context", copy.Value(x) == 5 && copy.Evaluate() == 4);
+
+        EvaluationContext other(compiled);
+        Check("Another context starts from the current values", other.Value(x) == 3 && other.Evaluate() == -2);
+
+        double gradient[2];
+        auto const value = context.EvaluateGradient({ x, a }, gradient);
+        Check("F'(x) = 5 and F'(a) = 25 in the context", value == 4 && gradient[0] == 5 && gradient[1] == 25);
+    }
+
+    //**********************************************************************************************************************
+
+    cout << endl << "-------------- Bindings are assigned all at once:" << endl << endl;
+
+    {
+        Variable u(1);
+        Variable w(2);
+
+        Bindings fibonacci = { { u, w }, { w, u + w } };
+        ExpressionGroup group(fibonacci);
+
+        AtomicAssign(group);
+        Check("(u, w) = (w, u+w) from (1, 2) by the group", u() == 2 && w() == 3);
+        AtomicAssign(group);
+        Check("... again from (2, 3)", u() == 3 && w() == 5);
+        AtomicAssign(fibonacci);
+        Check("... and from (3, 5) by the bindings", u() == 5 && w() == 8);
+    }
+
+    //**********************************************************************************************************************
+
+    cout << endl << "-------------- Directional derivatives agree with Derive():" << endl << endl;
+
+    {
+        Expression g = sin(quadratic) * exp(a * x) + sqrt(quadratic * quadratic + c);
+
+        std::vector<std::vector<std::pair<Variable, double>>> directions =
+        {
+            { { x, 1 } },
+            { { a, 1 } },
+            { { x, 0.5 }, { b, -2 } },
+            { { c, 1 }, { x, -1 }, { a, 0.25 } },
+            { { a, 1 }, { b, 1 }, { c, 1 }, { x, 1 } }
+        };
+
+        std::vector<std::pair<Variable, std::vector<double>>> lanes = { { a, {} }, { b, {} }, { c, {} }, { x, {} } };
+
+        for (auto& d : directions) for (auto& lane : lanes)
+        {
+            double component = 0;
+            for (auto& item : d) if (item.first.id() == lane.first.id()) component = item.second;
+            lane.second.push_back(component);
+        }
+
+        std::vector<double> derivatives(directions.size());
+        auto const value = g.EvaluateDirectional(lanes, derivatives.data());
+
+        Check("The value along with the derivatives", value == g.Evaluate());
+
+        for (size_t k = 0; k < directions.size(); ++k)
+        {
+            double expected = 0;
+            for (auto& item : directions[k]) expected += item.second * g.Derive(item.first).Evaluate();
+
+            auto const single = g.EvaluateDirectional(directions[k]);
+            auto const compiled = g.Compile().EvaluateDirectional(directions[k]);
+
+            std::ostringstream what;
+            what << "Direction " << k << ": " << single.second << " for " << expected;
+
+            Check(what.str(), std::abs(single.second - expected) <= 1e-12 * std::abs(expected));
+            Check("... the same in a lane of several", single.second == derivatives[k] && single.first == value);
+            Check("... and compiled", compiled == single);
+        }
+    }
+
+    //**********************************************************************************************************************
+
+    cout << endl << (failures ? "FAILED: " : "All passed: ") << failures << " failure(s)" << endl;
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+catch (std::exception e)
+{
+    cout << endl << e.what() << endl << endl;
+    return EXIT_FAILURE;
+}
+catch (char const* p)
+{
+    cout << endl << p << endl << endl;
+    return EXIT_FAILURE;
+}
+catch (...)
+{
+    cout << endl << "Diva tantrum!!!!" << endl << endl;
+    return EXIT_FAILURE;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,168 @@
+
+#include "Laskenta.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::endl;
+
+//**********************************************************************************************************************
+
+// Writes the source of 'Expression::Source()' into a program of its own, builds it with the compiler command of the
+// environment variable 'CXX' (by default 'c++ -std=c++14 -O2 -fno-builtin'), runs it, and compares the bits of each
+// value it prints with those of 'Evaluate()'.  NOTE: The command is given the generated file, 'Laskenta.cpp' for '::Li2'
+// and '::Spp', and '-o' for the program, so it has to accept those.  It should use the floating point options this
+// program was built with, and keep the compiler from folding the math functions of constant arguments: a compiler may
+// round those differently from the run-time library that 'Evaluate()' calls.
+
+static char const* const GENERATED = "codegen_generated";
+
+static int const SAMPLES = 601;
+
+static std::string Directory()  // Of the sources, from the path this file was compiled by
+{
+    std::string path = __FILE__;
+    auto const end = path.find_last_of("/\\");
+
+    return end == std::string::npos ? "." : path.substr(0, end);
+}
+
+static uint64_t Bits(double d)
+{
+    uint64_t n;
+    memcpy(&n, &d, sizeof n);
+    return n;
+}
+
+//**********************************************************************************************************************
+
+int main() try
+{
+    std::string const compiler = std::getenv("CXX") ? std::getenv("CXX") : "c++ -std=c++14 -O2 -fno-builtin";
+
+    Variable x;
+    Variable gain[20];
+    Variable bias[20];
+    Variable weight[20];
+
+    for (int i = 0; i < 20; ++i)
+    {
+        gain[i] = sin(i);
+        bias[i] = cos(i);
+        weight[i] = sin(i * 0.3);
+    }
+
+    Expression X = x;
+    Expression model = x * 0.5;
+
+    for (int i = 0; i < 20; ++i) model = model + weight[i] * tanh(gain[i] * x + bias[i]);
+
+    std::vector<Expression> group =  // <---- Every function, the operators, and signed zeros
+    {
+        model,
+        model.Derive(x),
+        sqrt(X * X + 1) + abs(X) * sgn(X) + cbrt(X) + exp(X) + expm1(X) + log(X * X + 2) + log1p(X * X) + sin(X) + cos(X) + tan(X) + 1 / cos(X),
+        asin(X / 10) + acos(X / 10) + atan(X) + sinh(X) + cosh(X) + tanh(X) + asinh(X) + acosh(X * X + 1) + atanh(X / 10) + erf(X) + erfc(X),
+        Li2(X / 10) + Spp(X) + pow(X * X + 1, X) + 1 / X - X + pow(X, 3),
+        1 / cosh(X) + sqrt(X * X - 1) + sqrt(1 - X * X / 100),
+        -0.0 * X,
+        Expression(-0.0)
+    };
+
+    //**********************************************************************************************************************
+
+    cout << endl << "-------------- Generating '" << GENERATED << ".cpp':" << endl << endl;
+
+    {
+        std::ofstream out(std::string(GENERATED) + ".cpp");
+
+        out << "#include <cstdint>\n#include <cstdio>\n#include <cstring>\n\n";
+        out << model.Source("model", { x }) << "\n" << Expression::Source(group, "group", { x }) << "\n";
+        out << "static unsigned long long bits(double d)\n{\n    uint64_t n;\n    memcpy(&n, &d, sizeof n);\n    return n;\n}\n\n";
+        out << "int main()\n{\n";
+        out << "    for (int k = 0; k < " << SAMPLES << "; ++k)\n    {\n";
+        out << "        double const x = (k - " << SAMPLES / 2 << ") / 37.0;\n";
+        out << "        double y[" << group.size() << "];\n\n";
+        out << "        group(&x, y);\n";
+        out << "        printf(\"%016llx\", bits(model(&x)));\n";
+        out << "        for (double d : y) printf(\" %016llx\", bits(d));\n";
+        out << "        printf(\"\\n\");\n    }\n}\n";
+    }
+
+    auto const command = compiler + " " + GENERATED + ".cpp \"" + Directory() + "/Laskenta.cpp\" -I\"" + Directory() + "\" -o " + GENERATED;
+
+    cout << command << endl;
+
+    if (std::system(command.c_str()) != 0)
+    {
+        cout << endl << "FAILED to compile" << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (std::system((std::string("./") + GENERATED + " > " + GENERATED + ".txt").c_str()) != 0)
+    {
+        cout << endl << "FAILED to run" << endl;
+        return EXIT_FAILURE;
+    }
+
+    //**********************************************************************************************************************
+
+    cout << endl << "-------------- Comparing with Evaluate():" << endl << endl;
+
+    std::ifstream in(std::string(GENERATED) + ".txt");
+    int compared = 0;
+    int failures = 0;
+
+    for (int k = 0; k < SAMPLES; ++k)
+    {
+        x = (k - SAMPLES / 2) / 37.0;
+
+        std::vector<double> expected = { model.Evaluate() };
+        for (auto& e : group) expected.push_back(e.Evaluate());
+
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            unsigned long long n = 0;
+
+            if (!(in >> std::hex >> n))
+            {
+                cout << "FAILED  output of the generated program ends at x = " << x() << endl;
+                return EXIT_FAILURE;
+            }
+
+            ++compared;
+
+            if (n != Bits(expected[i]) && ++failures <= 10)
+            {
+                cout << std::hexfloat << "FAILED  value " << i << " at x = " << x() << ": " << expected[i] << " by Evaluate()" << std::defaultfloat << endl;
+            }
+        }
+    }
+
+    cout << compared << " values compared, " << failures << " differ" << endl;
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+catch (std::exception e)
+{
+    cout << endl << e.what() << endl << endl;
+    return EXIT_FAILURE;
+}
+catch (char const* p)
+{
+    cout << endl << p << endl << endl;
+    return EXIT_FAILURE;
+}
+catch (...)
+{
+    cout << endl << "Diva tantrum!!!!" << endl << endl;
+    return EXIT_FAILURE;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -89,27 +89,31 @@ int main() try
 
     // 4. Create the training batch
 
-    Expression batch = 0;
+    std::vector<double> samples;
 
     for (int i = 0; i <= 180; ++i)
     {
         double d = (i - 90.0) / 90.0;
-        batch = batch + loss.Bind(x, d);
+        samples.push_back(d);
     }
 
-    batch = batch / 181;
+    Expression batch = Mean(loss.BindMany(x, samples));  // <---- All samples in one go, summed as a balanced tree
 
     // 5. Instrument the training set for gradient descent
 
+    std::vector<Variable> weights;
+
     for (size_t i = 0; i < N; ++i)
     {
-        cout << ".";
-        gradients.emplace_back(gain_0[i], gain_0[i] - rate * batch.Derive(gain_0[i]));
-        gradients.emplace_back(bias_0[i], bias_0[i] - rate * batch.Derive(bias_0[i]));
-        gradients.emplace_back(gain_1[i], gain_1[i] - rate * batch.Derive(gain_1[i]));
+        weights.push_back(gain_0[i]);
+        weights.push_back(bias_0[i]);
+        weights.push_back(gain_1[i]);
     }
-    cout << endl;
-    gradients.emplace_back(bias_1, bias_1 - rate * batch.Derive(bias_1));
+    weights.push_back(bias_1);
+
+    auto gradient = batch.Gradient(weights);  // <---- All partial derivatives in a single reverse sweep, equal to 'Derive()' up to rounding
+
+    for (size_t i = 0; i < weights.size(); ++i) gradients.emplace_back(weights[i], weights[i] - rate * gradient[i]);
 
     batch = batch.AtomicBind(gradients);
 
@@ -117,24 +121,38 @@ int main() try
 
     auto slope = batch.Derive(rate);
     auto converge = rate - slope / slope.Derive(rate);
+    ExpressionGroup descent(gradients);  // <---- The gradient step compiled once, the common subexpressions evaluated once for all
+
+#if defined(LASKENTA_JIT)
+    auto compiled = converge.Compile();  // <---- Newton step on the tape: a million instructions of machine code would not fit in the caches
+#elif defined(LASKENTA_THREADS)
+    auto compiled = converge.Compile();  // <---- Newton step with its independent subexpressions on all the cores
+#endif
 
     for (int i = 0; i < 850; ++i)
     {
         if (i % 10 == 0) cout << ".";
         // cout << batch() << ", " << rate() << endl;
 
+#if defined(LASKENTA_JIT)
+        rate = 0; rate = compiled.Evaluate();
+#elif defined(LASKENTA_THREADS)
+        rate = 0; rate = compiled.EvaluateParallel();
+#else
         rate = 0; rate = converge();
+#endif
         // rate = converge();
 
-        AtomicAssign(gradients);
+        AtomicAssign(descent);
     }
     cout << endl;
 
+    auto expected = expectation.Evaluate({ { x, samples } });  // <---- All samples at once, in SIMD lanes
+    auto computed = computation.Evaluate({ { x, samples } });
+
     for (int i = 0; i <= 180; ++i)
     {
-        double d = (i - 90.0) / 90.0;
-        x = d;
-        cout << x() << ", " << expectation() << ", " << computation() << endl;
+        cout << samples[i] << ", " << expected[i] << ", " << computed[i] << endl;
     }
 }
 catch (std::exception e)
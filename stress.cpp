@@ -0,0 +1,126 @@
+
+#include "Laskenta.h"
+
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using std::cout;
+using std::endl;
+
+//**********************************************************************************************************************
+
+// Several threads build, bind and derive graphs that share most of their nodes, all at the same time, and the results
+// are compared with those of a single thread.  The terms of a sum are ordered by the creation of the nodes, which the
+// threads interleave, so the values agree up to rounding.  Needs LASKENTA_THREADS, see 'Laskenta.h'.
+
+#if defined(LASKENTA_THREADS)
+
+static int const THREADS = 16;
+static int const ROUNDS = 20;
+static int const GRAPHS = 64;
+
+static Variable v[8];
+
+struct Graphs  // Built by one thread, evaluated after all of them have finished
+{
+    Expression e;
+    Expression bound;
+    Expression many;
+    Expression atomic;
+    Expression derivative;
+};
+
+static Graphs Build(int seed)
+{
+    Expression e = 0;
+
+    for (int i = 0; i < 200; ++i)  // <---- Seeds that differ by a multiple of 8 build the same graph
+    {
+        auto const j = (seed * 7 + i) % 8;
+
+        e = e + sin(v[j] * (i % 13) + (i % 5)) * exp(v[(j + 1) % 8] - 0.5 * (i % 3));
+        if (i % 17 == 0) e = sqrt(e * e + 1) + pow(v[j], (i % 4) + 0.5);
+    }
+
+    auto const k = seed % 8;
+    Bindings swap = { { v[k], v[(k + 1) % 8] * 2 }, { v[(k + 1) % 8], v[k] } };
+
+    return { e, e.Bind(v[k], 0.25), e.BindMany(v[k], { 0.5, 0.75 })[1], e.AtomicBind(swap), e.Derive(v[k]) };
+}
+
+static std::vector<double> Values(Graphs const& r)
+{
+    return { r.e.Evaluate(), r.bound.Evaluate(), r.many.Evaluate(), r.atomic.Evaluate(), r.derivative.Evaluate() };
+}
+
+static bool Close(double x, double y)
+{
+    return x == y || std::abs(x - y) <= 1e-9 * std::abs(y) || (std::isnan(x) && std::isnan(y));
+}
+
+#endif
+
+//**********************************************************************************************************************
+
+int main() try
+{
+#if defined(LASKENTA_THREADS)
+    for (int i = 0; i < 8; ++i) v[i] = 0.1 * (i + 1);
+
+    std::vector<std::vector<double>> expected;
+
+    for (int s = 0; s < GRAPHS; ++s) expected.push_back(Values(Build(s)));
+
+    int failures = 0;
+
+    for (int round = 0; round < ROUNDS; ++round)
+    {
+        std::vector<Graphs> graphs(GRAPHS);
+        std::vector<std::thread> threads;
+
+        for (int n = 0; n < THREADS; ++n) threads.emplace_back([&graphs, n]
+        {
+            for (int s = n; s < GRAPHS; s += THREADS) graphs[s] = Build(s);
+        });
+
+        for (auto& t : threads) t.join();
+
+        for (int s = 0; s < GRAPHS; ++s)
+        {
+            auto const values = Values(graphs[s]);
+
+            for (size_t i = 0; i < values.size(); ++i) if (!Close(values[i], expected[s][i]) && ++failures <= 10)
+            {
+                cout << "FAILED  graph " << s << ", result " << i << " in round " << round << ": " << values[i] << " for " << expected[s][i] << endl;
+            }
+        }
+    }
+
+    cout << THREADS << " threads, " << ROUNDS << " rounds: " << failures << " failure(s)" << endl;
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+#else
+    cout << "Define LASKENTA_THREADS in 'Laskenta.h' for this test" << endl;
+
+    return EXIT_SUCCESS;
+#endif
+}
+catch (std::exception e)
+{
+    cout << endl << e.what() << endl << endl;
+    return EXIT_FAILURE;
+}
+catch (char const* p)
+{
+    cout << endl << p << endl << endl;
+    return EXIT_FAILURE;
+}
+catch (...)
+{
+    cout << endl << "Diva tantrum!!!!" << endl << endl;
+    return EXIT_FAILURE;
+}
+
+//----------------------------------------------------------------------------------------------------------------------